@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BLOCK_KERNEL_H_
+#define BLOCK_KERNEL_H_
+
+#include <stdbool.h>
+
+#include "board.h"
+
+enum gol_isa {
+  isaScalar = 0,
+  isaSSE2,
+  isaAVX2,
+  isaAVX512,
+  unknownIsa,
+};
+
+extern char *gol_isa_string[unknownIsa];
+
+// Calls X(name, rule, arg) for each rule getting a kernel, unknownRule being
+// the generic kernel of any other rule.
+#define GOL_RULE_KERNELS(X, arg)                                               \
+  X(life, lifeRule, arg) X(hilife, highLifeRule, arg) X(generic, unknownRule, arg)
+
+// Writes the next generation of the center block of the neighbourhood to the
+// rows `out`. The rule is only read by the generic kernel.
+typedef void (*gol_block_kernel)(const struct basic_block *[3][3],
+                                 block_type *out, struct gol_rule rule);
+
+// Generations advanced by a temporally blocked pass, the halo of a block
+// cannot be wider than half its shorter side. Up to 32 cells wide, a pass
+// costs more in block bookkeeping than in cells, so the largest halo is the
+// fastest. 64-wide halos only fit in __int128 words, slower than single steps.
+#define GOL_MAX_TEMPORAL_STEPS (BLOCK_HEIGHT / 2)
+#define GOL_DEFAULT_TEMPORAL_STEPS (BLOCKSIZE <= 32 ? GOL_MAX_TEMPORAL_STEPS : 1)
+
+// Same as gol_block_kernel, advancing the center block by 1 to
+// GOL_MAX_TEMPORAL_STEPS generations.
+typedef void (*gol_multistep_kernel)(const struct basic_block *[3][3],
+                                     block_type *out, size_t steps,
+                                     struct gol_rule rule);
+
+enum gol_isa detect_gol_isa(void);
+
+bool gol_isa_supported(enum gol_isa isa);
+
+void select_gol_isa(enum gol_isa isa);
+
+enum gol_isa get_gol_isa(void);
+
+gol_block_kernel get_block_kernel(struct gol_rule rule);
+
+gol_multistep_kernel get_multistep_kernel(struct gol_rule rule);
+
+#endif // BLOCK_KERNEL_H_
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Block kernel template, included once per instruction set by block_kernel.c.
+// The includer defines:
+//   KERNEL_WORD        type holding KERNEL_LANES consecutive block rows
+//   KERNEL_LANES       number of block rows per KERNEL_WORD
+//   KERNEL_NAME(name)  mangles the name of the generated functions
+//   KERNEL_ATTRIBUTES  function attributes (e.g. the target instruction set)
+
+#include "row_kernel_template.h"
+
+// Loads the rows [row, row + KERNEL_LANES) of a padded block column and
+// shifts in the edge bits of the west and east columns.
+KERNEL_ATTRIBUTES __attribute__((always_inline)) static inline void
+KERNEL_NAME(load_rows)(const block_type *west, const block_type *center,
+                       const block_type *east, size_t row, KERNEL_WORD *w,
+                       KERNEL_WORD *c, KERNEL_WORD *e) {
+  KERNEL_WORD wr, er;
+  memcpy(&wr, &west[row], sizeof(wr));
+  memcpy(c, &center[row], sizeof(*c));
+  memcpy(&er, &east[row], sizeof(er));
+  *w = (KERNEL_WORD)((*c << 1) | (wr >> (BLOCKSIZE - 1)));
+  *e = (KERNEL_WORD)((*c >> 1) | (er << (BLOCKSIZE - 1)));
+}
+
+// Computes the next state of the center block of the 3x3 neighbourhood,
+// KERNEL_LANES block rows per step.
+KERNEL_ATTRIBUTES __attribute__((always_inline)) static inline void
+KERNEL_NAME(evolve_block)(const struct basic_block *neighbourhood[3][3],
+                          block_type *out, enum gol_rules rule,
+                          struct gol_rule generic) {
+  block_type column[3][BLOCK_HEIGHT + 2];
+  for (size_t i = 0; i < 3; ++i) {
+    column[i][0] = gol_block_values(neighbourhood[0][i])[BLOCK_HEIGHT - 1];
+    memcpy(&column[i][1], gol_block_values(neighbourhood[1][i]),
+           sizeof(neighbourhood[1][i]->planes[0]));
+    column[i][BLOCK_HEIGHT + 1] = gol_block_values(neighbourhood[2][i])[0];
+  }
+  for (size_t i = 0; i < BLOCK_HEIGHT; i += KERNEL_LANES) {
+    KERNEL_WORD upW, up, upE, midW, mid, midE, downW, down, downE;
+    KERNEL_NAME(load_rows)(column[0], column[1], column[2], i, &upW, &up, &upE);
+    KERNEL_NAME(load_rows)
+    (column[0], column[1], column[2], i + 1, &midW, &mid, &midE);
+    KERNEL_NAME(load_rows)
+    (column[0], column[1], column[2], i + 2, &downW, &down, &downE);
+    KERNEL_WORD next = KERNEL_NAME(row_next_state)(
+        upW, up, upE, midW, mid, midE, downW, down, downE, rule, generic);
+    memcpy(&out[i], &next, sizeof(next));
+  }
+}
+
+#define BLOCK_KERNEL_WRAPPER(name, rule, unused)                               \
+  KERNEL_ATTRIBUTES static void KERNEL_NAME(evolve_block_##name)(              \
+      const struct basic_block *nb[3][3], block_type *out,                    \
+      struct gol_rule generic) {                                               \
+    KERNEL_NAME(evolve_block)(nb, out, rule, generic);                         \
+  }
+GOL_RULE_KERNELS(BLOCK_KERNEL_WRAPPER, )
+#undef BLOCK_KERNEL_WRAPPER
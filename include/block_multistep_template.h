@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Temporally blocked kernel template, included once per instruction set by
+// block_kernel.c. The includer defines:
+//   KERNEL_WORD        type holding KERNEL_LANES consecutive wide rows
+//   KERNEL_LANES       number of wide rows per KERNEL_WORD
+//   KERNEL_NAME(name)  mangles the name of the generated functions
+//   KERNEL_ATTRIBUTES  function attributes (e.g. the target instruction set)
+//
+// A wide row (wide_block_type) holds a block row with a halo of `steps` cells
+// on each side. The block and its halo rows are advanced `steps` generations
+// in two local row buffers, the valid area shrinking by one cell per
+// generation until only the block remains.
+
+#include "row_kernel_template.h"
+
+KERNEL_ATTRIBUTES __attribute__((always_inline)) static inline void
+KERNEL_NAME(evolve_block_steps)(const struct basic_block *neighbourhood[3][3],
+                                block_type *out, size_t steps,
+                                enum gol_rules rule, struct gol_rule generic) {
+  wide_block_type rows[2][2 * BLOCK_HEIGHT + KERNEL_LANES];
+  const size_t halo = steps, num_rows = BLOCK_HEIGHT + 2 * halo;
+  for (size_t r = 0; r < num_rows; ++r) {
+    size_t j = (r + BLOCK_HEIGHT - halo) / BLOCK_HEIGHT;
+    size_t row = (r + BLOCK_HEIGHT - halo) % BLOCK_HEIGHT;
+    rows[0][r] =
+        (wide_block_type)(gol_block_values(neighbourhood[j][0])[row] >>
+                          (BLOCKSIZE - halo)) |
+        (wide_block_type)((wide_block_type)gol_block_values(
+                              neighbourhood[j][1])[row]
+                          << halo) |
+        (wide_block_type)((wide_block_type)gol_block_values(
+                              neighbourhood[j][2])[row]
+                          << (BLOCKSIZE + halo));
+  }
+  // The rows past the shrinking valid area are computed but never used.
+  memset(&rows[0][num_rows], 0, KERNEL_LANES * sizeof(wide_block_type));
+  memset(rows[1], 0, sizeof(rows[1]));
+  for (size_t s = 1; s <= steps; ++s) {
+    const wide_block_type *previous = rows[(s - 1) % 2];
+    wide_block_type *next = rows[s % 2];
+    for (size_t r = s; r < num_rows - s; r += KERNEL_LANES) {
+      KERNEL_WORD up, mid, down;
+      memcpy(&up, &previous[r - 1], sizeof(up));
+      memcpy(&mid, &previous[r], sizeof(mid));
+      memcpy(&down, &previous[r + 1], sizeof(down));
+      KERNEL_WORD state = KERNEL_NAME(row_next_state)(
+          (KERNEL_WORD)(up << 1), up, (KERNEL_WORD)(up >> 1),
+          (KERNEL_WORD)(mid << 1), mid, (KERNEL_WORD)(mid >> 1),
+          (KERNEL_WORD)(down << 1), down, (KERNEL_WORD)(down >> 1), rule,
+          generic);
+      memcpy(&next[r], &state, sizeof(state));
+    }
+  }
+  for (size_t i = 0; i < BLOCK_HEIGHT; ++i)
+    out[i] = (block_type)(rows[steps % 2][halo + i] >> halo);
+}
+
+#define MULTISTEP_KERNEL_WRAPPER(name, rule, unused)                           \
+  KERNEL_ATTRIBUTES static void KERNEL_NAME(evolve_block_steps_##name)(        \
+      const struct basic_block *nb[3][3], block_type *out,                    \
+      size_t steps, struct gol_rule generic) {                                 \
+    KERNEL_NAME(evolve_block_steps)(nb, out, steps, rule, generic);            \
+  }
+GOL_RULE_KERNELS(MULTISTEP_KERNEL_WRAPPER, )
+#undef MULTISTEP_KERNEL_WRAPPER
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BLOCK_POOL_H_
+#define BLOCK_POOL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "geometry_names.h"
+
+struct basic_block;
+
+// Blocks of a board are carved out of large slabs and recycled through a free
+// list, so that the engines do not go through malloc for every block of every
+// generation. Each block starts on its own cache line, or on a fraction of one
+// for blocks smaller than a cache line.
+struct block_pool {
+  // Released blocks, linked through their first bytes
+  void *free_list;
+  // Never used part of the last slab
+  char *next, *end;
+  void **slabs;
+  size_t num_slabs;
+};
+
+void init_block_pool(struct block_pool *pool);
+
+// Returns a zeroed block.
+struct basic_block *new_pooled_block(struct block_pool *pool);
+
+void release_pooled_block(struct basic_block *bb, struct block_pool *pool);
+
+// Gives the slabs back to the system, every block of the pool is released.
+void free_block_pool(struct block_pool *pool);
+
+// The pool has more than twice the slabs needed by num_blocks blocks, plus
+// one.
+__attribute__((pure)) bool block_pool_oversized(const struct block_pool *pool,
+                                                size_t num_blocks);
+
+// Back the slabs allocated from now on by explicit huge pages, when the system
+// has some available.
+void set_huge_pages(bool enable);
+
+#endif // BLOCK_POOL_H_
@@ -36,10 +36,89 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include "geometry_names.h"
+
+#define uintbis(a) uint##a##_t
+#define uint(a) uintbis(a)
+
+#define uintdefbis(a, b) UINT##a##_C(b)
+#define uintdef(a, b) uintdefbis(a, b)
+#define intdefbis(a, b) INT##a##_C(b)
+#define intdef(a, b) intdefbis(a, b)
+
+#define block_type uint(BLOCKSIZE)
+
+// Neighbours of a block in the order of its 3x3 neighbourhood read row by row,
+// north being the previous row of blocks.
+enum gol_neighbour {
+  neighbourNW = 0,
+  neighbourN,
+  neighbourNE,
+  neighbourW,
+  neighbourE,
+  neighbourSW,
+  neighbourS,
+  neighbourSE,
+  allNeighbours,
+};
+
+struct basic_block {
+  // planes[plane] is the current generation of the block, the block engine
+  // computes the next one in the other plane then flips `plane`.
+  block_type planes[2][BLOCK_HEIGHT];
+  // Allocated neighbouring blocks of the same board, NULL otherwise. The
+  // opposite of neighbour k is allNeighbours - 1 - k.
+  struct basic_block *neighbours[allNeighbours];
+  // Hash of the alive cells at their place in the pattern, maintained by the
+  // block engine
+  uint64_t hash;
+  // Same values as during the previous generation
+  bool unchanged;
+  uint8_t plane;
+};
+
+__attribute__((pure)) static inline const block_type *
+gol_block_values(const struct basic_block *bb) {
+  return bb->planes[bb->plane];
+}
+
+__attribute__((pure)) static inline bool
+gol_block_empty(const struct basic_block *b) {
+  bool continue_search = true;
+  for (size_t i = 0; i < BLOCK_HEIGHT && continue_search; ++i) {
+    continue_search = gol_block_values(b)[i] == uintdef(BLOCKSIZE, 0);
+  }
+  return continue_search;
+}
+
+__attribute__((const)) static inline size_t block_lowest_bit(block_type v) {
+  return (size_t)__builtin_ctzll((unsigned long long)v);
+}
+
+__attribute__((const)) static inline size_t block_highest_bit(block_type v) {
+  return (size_t)(63 - __builtin_clzll((unsigned long long)v));
+}
+
+// Bounding box of the alive cells, in pattern coordinates.
 struct gol_board_bounds {
   intmax_t upperX, upperY, lowerX, lowerY;
 };
 
+// Bounds of a board without alive cells, extending them with other bounds
+// gives these other bounds.
+#define GOL_EMPTY_BOUNDS                                                       \
+  ((struct gol_board_bounds){.upperX = INTMAX_MIN,                             \
+                             .upperY = INTMAX_MIN,                             \
+                             .lowerX = INTMAX_MAX,                             \
+                             .lowerY = INTMAX_MAX})
+
+// Outer-totalistic rule: bit n of birth (survival) is set when a dead (alive)
+// cell with n alive neighbours is alive during the next generation.
+struct gol_rule {
+  uint16_t birth, survival;
+};
+
+// Rules with their own specialized kernels, any other rule is unknownRule.
 enum gol_rules {
   lifeRule = 0,
   highLifeRule,
@@ -48,8 +127,45 @@ enum gol_rules {
 
 extern char *gol_rule_string[unknownRule];
 
+extern const struct gol_rule gol_rule_definition[unknownRule];
+
+__attribute__((const)) enum gol_rules gol_rule_kind(struct gol_rule rule);
+
+// "B012345678/S012345678" and the terminating null character
+#define GOL_RULE_STRING_SIZE 22
+
+// Accepts B.../S... in any case and order (the slash being optional) as well
+// as the S/B notation "23/3". Rules with B0 are rejected, the infinite empty
+// background would then be alive.
+bool parse_gol_rule(const char *rulestring, struct gol_rule *rule);
+
+void format_gol_rule(struct gol_rule rule, char string[GOL_RULE_STRING_SIZE]);
+
+__attribute__((const)) static inline bool
+gol_next_state(struct gol_rule rule, bool alive, size_t num_alive) {
+  return ((alive ? rule.survival : rule.birth) >> num_alive) & 1;
+}
+
 struct gol_board;
 
+// Data structure mapping block coordinates to blocks.
+enum gol_board_index {
+  indexSpiral = 0,
+  indexHash,
+  indexMorton,
+  unknownIndex,
+};
+
+extern char *gol_board_index_string[unknownIndex];
+
+// Index of the boards created from now on. The spiral and Morton indexes are
+// direct lookups but their size grows with the square of the distance between
+// the origin and the farthest block, the hash index is proportional to the
+// number of blocks. The Morton index lists the blocks tile by tile along the
+// Z-order curve, so that the block engine allocates and visits neighbouring
+// blocks together.
+void set_board_index(enum gol_board_index index);
+
 struct gol_board_iterator_position {
   intmax_t posX, posY;
 };
@@ -60,19 +176,36 @@ __attribute__((pure)) bool read_gol_board(intmax_t posX, intmax_t posY,
 void write_gol_board(intmax_t posX, intmax_t posY, bool val,
                      struct gol_board *b);
 
+// Sets the length cells of row posY starting at column posX alive, a whole
+// block row at a time.
+void write_gol_board_run(intmax_t posX, intmax_t posY, intmax_t length,
+                         struct gol_board *b);
+
 struct gol_board *new_board(void);
 
+// The bounds of an empty board are the single cell at the origin.
 __attribute__((pure)) struct gol_board_bounds
 get_game_bounds(const struct gol_board *b);
 
 void clean_board(struct gol_board *b);
 
+// Releases the blocks that stayed empty during the last generation away from
+// the alive blocks, then shrinks the index, the block list and the block pool
+// of the board to the remaining blocks. The blocks may move.
+void compact_board(struct gol_board *b);
+
+// The board holds far fewer blocks than it has memory for.
+__attribute__((pure)) bool board_needs_compaction(const struct gol_board *b);
+
 void free_board(struct gol_board *b);
 
 void set_offset(intmax_t offsetX, intmax_t offsetY, struct gol_board *b);
 
-void set_game_rules(enum gol_rules rule, struct gol_board *b);
-__attribute__((pure)) enum gol_rules get_game_rules(const struct gol_board *b);
+// Moves the pattern by (dx, dy) cells, only the offset and bounds change.
+void translate_board(intmax_t dx, intmax_t dy, struct gol_board *b);
+
+void set_game_rules(struct gol_rule rule, struct gol_board *b);
+__attribute__((pure)) struct gol_rule get_game_rules(const struct gol_board *b);
 
 void gol_copy_board(const struct gol_board *to_copy, struct gol_board *copy);
 
@@ -84,7 +217,10 @@ __attribute__((pure)) bool gol_same_board(const struct gol_board *b1,
 void get_offset(const struct gol_board *board, intmax_t *offsetX,
                 intmax_t *offsetY);
 
-void dump_board_ASCII(FILE *outStream, struct gol_board *b);
+// Cells of the viewport, NULL for the bounds of the pattern, as 'O' (alive) and
+// ' ' (dead).
+void dump_board_ASCII(FILE *outStream, const struct gol_board *b,
+                      const struct gol_board_bounds *viewport);
 
 struct gol_game {
   struct gol_board *board;
@@ -98,7 +234,8 @@ void clone_metadata(const struct gol_game *b1, struct gol_game *b2);
 
 void free_game(struct gol_game *game);
 
-void dump_ASCII(FILE *outStream, struct gol_game *b);
+void dump_ASCII(FILE *outStream, struct gol_game *b,
+                const struct gol_board_bounds *viewport);
 
 void add_comment(const char *comment, struct gol_game *b);
 
@@ -118,4 +255,55 @@ struct gol_board_iterator_position board_iterator_position(struct gol_board_iter
 
 bool board_iterator_equal(struct gol_board_iterator *it1, struct gol_board_iterator *it2);
 
+// Block level access, block coordinates are expressed in the storage frame
+// (cell position plus board offset) divided by BLOCKSIZE along X and by
+// BLOCK_HEIGHT along Y.
+
+struct gol_block_position {
+  intmax_t bx, by;
+};
+
+// Block coordinates of a storage frame position.
+__attribute__((const)) static inline intmax_t block_coordinate_x(intmax_t pos) {
+  return pos >= 0 ? pos / intdef(MAX, BLOCKSIZE)
+                  : -((-(pos + 1)) / intdef(MAX, BLOCKSIZE)) - 1;
+}
+
+__attribute__((const)) static inline intmax_t block_coordinate_y(intmax_t pos) {
+  return pos >= 0 ? pos / intdef(MAX, BLOCK_HEIGHT)
+                  : -((-(pos + 1)) / intdef(MAX, BLOCK_HEIGHT)) - 1;
+}
+
+__attribute__((pure)) struct basic_block *
+get_gol_block(intmax_t bx, intmax_t by, const struct gol_board *b);
+
+struct basic_block *get_or_new_gol_block(intmax_t bx, intmax_t by,
+                                         struct gol_board *b);
+
+// Bounds of the alive cells of a block whose first cell is at (originX,
+// originY) in pattern coordinates, false for an empty block.
+bool gol_block_bounds(const struct basic_block *bb, intmax_t originX,
+                      intmax_t originY, struct gol_board_bounds *bounds);
+
+void extend_game_bounds(const struct gol_board_bounds *bounds,
+                        struct gol_board *b);
+
+// The bounds must be the exact bounds of the alive cells, GOL_EMPTY_BOUNDS
+// for an empty board.
+void set_game_bounds(const struct gol_board_bounds *bounds,
+                     struct gol_board *b);
+
+size_t list_gol_blocks(const struct gol_board *b,
+                       struct gol_block_position **positions);
+
+// Number of allocated blocks, empty ones included.
+__attribute__((pure)) size_t
+gol_board_num_blocks(const struct gol_board *b);
+
+// Allocated block n < gol_board_num_blocks(b) and its block coordinates. The
+// blocks keep their number until the next compact_board or clean_board, new
+// blocks get the following numbers.
+struct basic_block *gol_board_block(const struct gol_board *b, size_t n,
+                                    intmax_t *bx, intmax_t *by);
+
 #endif
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CYCLE_H_
+#define CYCLE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board.h"
+
+// Hash of the alive cells of a block whose first cell is at (x, y) in pattern
+// coordinates: the sum of A^i B^j over its alive cells (i, j), modulo 2^64.
+// Moving a pattern by (dx, dy) multiplies its hash by A^dx B^dy.
+__attribute__((pure)) uint64_t gol_block_hash(const struct basic_block *bb,
+                                              intmax_t x, intmax_t y);
+
+// Hash of the pattern moved so that its bounds start at the origin.
+__attribute__((pure)) uint64_t
+gol_canonical_hash(uint64_t hash, struct gol_board_bounds bounds);
+
+struct gol_cycle_detector;
+
+struct gol_cycle_detector *new_cycle_detector(void);
+
+void free_cycle_detector(struct gol_cycle_detector *cd);
+
+// Records the hash of the board reached at generation `current`. Once the
+// board is known to repeat itself, possibly moved, every `period` generations,
+// the board is moved to where it would be after the largest number of periods
+// fitting before `generation` and this number of generations is returned.
+size_t detect_cycle(struct gol_cycle_detector *cd, struct gol_board *board,
+                    uint64_t hash, size_t current, size_t generation,
+                    bool verbose);
+
+#endif // CYCLE_H_
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GEOMETRY_H_
+#define GEOMETRY_H_
+
+#include <getopt.h>
+#include <stdbool.h>
+
+// X(width, height) for every block geometry compiled in the binary, the first
+// one being the default. Must match GOL_GEOMETRIES in src/CMakeLists.txt.
+#define GOL_GEOMETRIES(X) X(32, 32) X(8, 8) X(64, 64) X(64, 16)
+
+// Runs the program with the blocks of the geometry, see main.c.
+#define GOL_RUN_DECLARATION(width, height)                                     \
+  int run_gol_##width##x##height(int argc, char **argv);
+GOL_GEOMETRIES(GOL_RUN_DECLARATION)
+#undef GOL_RUN_DECLARATION
+
+// Command line options, parsed by main() to select the geometry then by the
+// run_gol of that geometry.
+extern const struct option gol_long_options[];
+extern const char gol_short_options[];
+
+// The file name ends with the extension, e.g. ".mc".
+bool gol_has_extension(const char *file_name, const char *extension);
+
+#endif // GEOMETRY_H_
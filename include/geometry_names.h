@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GEOMETRY_NAMES_H_
+#define GEOMETRY_NAMES_H_
+
+// Included first by every header of the modules depending on the block
+// geometry. These modules are compiled once per geometry with BLOCKSIZE (the
+// width of a block, also the number of bits of its rows) and BLOCK_HEIGHT (its
+// number of rows) defined, their external symbols are renamed to name_WxH so
+// that the geometries can be linked together.
+
+#ifndef BLOCKSIZE
+#define BLOCKSIZE 32
+#endif
+
+#ifndef BLOCK_HEIGHT
+#define BLOCK_HEIGHT BLOCKSIZE
+#endif
+
+#if BLOCK_HEIGHT > BLOCKSIZE
+#error "The columns of a block are stored in block_type, BLOCK_HEIGHT must not exceed BLOCKSIZE"
+#endif
+
+#define GOL_GEOMETRY_NAME_PASTE(name, width, height) name##_##width##x##height
+#define GOL_GEOMETRY_NAME_EXPAND(name, width, height)                          \
+  GOL_GEOMETRY_NAME_PASTE(name, width, height)
+#define GOL_GEOMETRY_NAME(name)                                                \
+  GOL_GEOMETRY_NAME_EXPAND(name, BLOCKSIZE, BLOCK_HEIGHT)
+
+#define GOL_GEOMETRY_STRING_PASTE(width, height) #width "x" #height
+#define GOL_GEOMETRY_STRING_EXPAND(width, height)                              \
+  GOL_GEOMETRY_STRING_PASTE(width, height)
+// "WxH"
+#define GOL_GEOMETRY_STRING GOL_GEOMETRY_STRING_EXPAND(BLOCKSIZE, BLOCK_HEIGHT)
+
+// board.h
+#define add_comment GOL_GEOMETRY_NAME(add_comment)
+#define board_iterator_equal GOL_GEOMETRY_NAME(board_iterator_equal)
+#define board_iterator_free GOL_GEOMETRY_NAME(board_iterator_free)
+#define board_iterator_is_end GOL_GEOMETRY_NAME(board_iterator_is_end)
+#define board_iterator_next GOL_GEOMETRY_NAME(board_iterator_next)
+#define board_iterator_position GOL_GEOMETRY_NAME(board_iterator_position)
+#define board_iterator_start GOL_GEOMETRY_NAME(board_iterator_start)
+#define clean_board GOL_GEOMETRY_NAME(clean_board)
+#define board_needs_compaction GOL_GEOMETRY_NAME(board_needs_compaction)
+#define clone_metadata GOL_GEOMETRY_NAME(clone_metadata)
+#define compact_board GOL_GEOMETRY_NAME(compact_board)
+#define dump_ASCII GOL_GEOMETRY_NAME(dump_ASCII)
+#define dump_board_ASCII GOL_GEOMETRY_NAME(dump_board_ASCII)
+#define extend_game_bounds GOL_GEOMETRY_NAME(extend_game_bounds)
+#define format_gol_rule GOL_GEOMETRY_NAME(format_gol_rule)
+#define free_board GOL_GEOMETRY_NAME(free_board)
+#define free_game GOL_GEOMETRY_NAME(free_game)
+#define get_game_bounds GOL_GEOMETRY_NAME(get_game_bounds)
+#define get_game_rules GOL_GEOMETRY_NAME(get_game_rules)
+#define get_gol_block GOL_GEOMETRY_NAME(get_gol_block)
+#define get_offset GOL_GEOMETRY_NAME(get_offset)
+#define get_or_new_gol_block GOL_GEOMETRY_NAME(get_or_new_gol_block)
+#define gol_block_bounds GOL_GEOMETRY_NAME(gol_block_bounds)
+#define gol_board_index_string GOL_GEOMETRY_NAME(gol_board_index_string)
+#define gol_board_block GOL_GEOMETRY_NAME(gol_board_block)
+#define gol_board_num_blocks GOL_GEOMETRY_NAME(gol_board_num_blocks)
+#define gol_copy_board GOL_GEOMETRY_NAME(gol_copy_board)
+#define gol_rule_definition GOL_GEOMETRY_NAME(gol_rule_definition)
+#define gol_rule_kind GOL_GEOMETRY_NAME(gol_rule_kind)
+#define gol_rule_string GOL_GEOMETRY_NAME(gol_rule_string)
+#define gol_same_board GOL_GEOMETRY_NAME(gol_same_board)
+#define gol_swap_board GOL_GEOMETRY_NAME(gol_swap_board)
+#define list_gol_blocks GOL_GEOMETRY_NAME(list_gol_blocks)
+#define new_board GOL_GEOMETRY_NAME(new_board)
+#define parse_gol_rule GOL_GEOMETRY_NAME(parse_gol_rule)
+#define read_gol_board GOL_GEOMETRY_NAME(read_gol_board)
+#define set_author GOL_GEOMETRY_NAME(set_author)
+#define set_board_index GOL_GEOMETRY_NAME(set_board_index)
+#define set_game_bounds GOL_GEOMETRY_NAME(set_game_bounds)
+#define set_game_rules GOL_GEOMETRY_NAME(set_game_rules)
+#define set_offset GOL_GEOMETRY_NAME(set_offset)
+#define set_pattern_name GOL_GEOMETRY_NAME(set_pattern_name)
+#define translate_board GOL_GEOMETRY_NAME(translate_board)
+#define write_gol_board GOL_GEOMETRY_NAME(write_gol_board)
+#define write_gol_board_run GOL_GEOMETRY_NAME(write_gol_board_run)
+
+// block_pool.h
+#define block_pool_oversized GOL_GEOMETRY_NAME(block_pool_oversized)
+#define free_block_pool GOL_GEOMETRY_NAME(free_block_pool)
+#define init_block_pool GOL_GEOMETRY_NAME(init_block_pool)
+#define new_pooled_block GOL_GEOMETRY_NAME(new_pooled_block)
+#define release_pooled_block GOL_GEOMETRY_NAME(release_pooled_block)
+#define set_huge_pages GOL_GEOMETRY_NAME(set_huge_pages)
+
+// block_kernel.h
+#define detect_gol_isa GOL_GEOMETRY_NAME(detect_gol_isa)
+#define get_block_kernel GOL_GEOMETRY_NAME(get_block_kernel)
+#define get_gol_isa GOL_GEOMETRY_NAME(get_gol_isa)
+#define get_multistep_kernel GOL_GEOMETRY_NAME(get_multistep_kernel)
+#define gol_isa_string GOL_GEOMETRY_NAME(gol_isa_string)
+#define gol_isa_supported GOL_GEOMETRY_NAME(gol_isa_supported)
+#define select_gol_isa GOL_GEOMETRY_NAME(select_gol_isa)
+
+// cycle.h
+#define detect_cycle GOL_GEOMETRY_NAME(detect_cycle)
+#define free_cycle_detector GOL_GEOMETRY_NAME(free_cycle_detector)
+#define gol_block_hash GOL_GEOMETRY_NAME(gol_block_hash)
+#define gol_canonical_hash GOL_GEOMETRY_NAME(gol_canonical_hash)
+#define new_cycle_detector GOL_GEOMETRY_NAME(new_cycle_detector)
+
+// life.h
+#define evolve_to_generation_n GOL_GEOMETRY_NAME(evolve_to_generation_n)
+#define get_temporal_steps GOL_GEOMETRY_NAME(get_temporal_steps)
+#define gol_engine_string GOL_GEOMETRY_NAME(gol_engine_string)
+#define rewind_to_generation GOL_GEOMETRY_NAME(rewind_to_generation)
+#define set_fixed_frame GOL_GEOMETRY_NAME(set_fixed_frame)
+#define set_gol_history GOL_GEOMETRY_NAME(set_gol_history)
+#define set_temporal_steps GOL_GEOMETRY_NAME(set_temporal_steps)
+
+// history.h
+#define find_gol_snapshot GOL_GEOMETRY_NAME(find_gol_snapshot)
+#define free_gol_history GOL_GEOMETRY_NAME(free_gol_history)
+#define gol_history_size GOL_GEOMETRY_NAME(gol_history_size)
+#define new_gol_history GOL_GEOMETRY_NAME(new_gol_history)
+#define record_gol_generation GOL_GEOMETRY_NAME(record_gol_generation)
+#define release_gol_snapshot GOL_GEOMETRY_NAME(release_gol_snapshot)
+#define restore_gol_snapshot GOL_GEOMETRY_NAME(restore_gol_snapshot)
+#define retain_gol_snapshot GOL_GEOMETRY_NAME(retain_gol_snapshot)
+#define take_gol_snapshot GOL_GEOMETRY_NAME(take_gol_snapshot)
+
+// occupancy.h
+#define free_gol_occupancy GOL_GEOMETRY_NAME(free_gol_occupancy)
+#define gol_occupancy_superblocks GOL_GEOMETRY_NAME(gol_occupancy_superblocks)
+#define new_gol_occupancy GOL_GEOMETRY_NAME(new_gol_occupancy)
+
+// hashlife.h
+#define hashlife_evolve_to_generation_n GOL_GEOMETRY_NAME(hashlife_evolve_to_generation_n)
+
+// rle.h
+#define dump_rle GOL_GEOMETRY_NAME(dump_rle)
+#define parse_rle_file GOL_GEOMETRY_NAME(parse_rle_file)
+
+// macrocell.h
+#define dump_macrocell GOL_GEOMETRY_NAME(dump_macrocell)
+#define parse_macrocell_file GOL_GEOMETRY_NAME(parse_macrocell_file)
+
+// main.c
+#define run_gol GOL_GEOMETRY_NAME(run_gol)
+
+#endif // GEOMETRY_NAMES_H_
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include <stddef.h>
+
+#include "board.h"
+
+// Read-only copy of a board. The blocks of a snapshot are reference counted
+// and shared with the snapshots taken after it as long as they do not change,
+// so a snapshot per generation only costs the blocks that changed. Writing to
+// a board restored from a snapshot never affects the snapshot.
+struct gol_snapshot;
+
+// Snapshot of the board sharing the blocks found unchanged, at the same place
+// of the pattern, in `previous` (may be NULL).
+struct gol_snapshot *take_gol_snapshot(const struct gol_board *board,
+                                       const struct gol_snapshot *previous);
+
+struct gol_snapshot *retain_gol_snapshot(struct gol_snapshot *snapshot);
+
+void release_gol_snapshot(struct gol_snapshot *snapshot);
+
+void restore_gol_snapshot(const struct gol_snapshot *snapshot,
+                          struct gol_board *board);
+
+// Ring of the snapshots of the last recorded generations.
+struct gol_history;
+
+struct gol_history *new_gol_history(size_t capacity);
+
+void free_gol_history(struct gol_history *history);
+
+// The oldest snapshot is dropped once the ring is full.
+void record_gol_generation(struct gol_history *history,
+                           const struct gol_board *board, size_t generation);
+
+// Newest snapshot taken at or before the generation, NULL if the generation is
+// older than the oldest snapshot or newer than the newest one.
+__attribute__((pure)) const struct gol_snapshot *
+find_gol_snapshot(const struct gol_history *history, size_t generation,
+                  size_t *snapshot_generation);
+
+// Numbers of retained snapshots and of distinct blocks they hold.
+void gol_history_size(const struct gol_history *history, size_t *num_snapshots,
+                      size_t *num_blocks);
+
+#endif // HISTORY_H_
@@ -35,7 +35,41 @@
 
 #include "board.h"
 
+enum gol_engine {
+  engineDense = 0,
+  engineIterator,
+  engineBlock,
+  engineHashlife,
+  engineTemporal,
+  unknownEngine,
+};
+
+extern char *gol_engine_string[unknownEngine];
+
+// Generations advanced per pass by the temporal engine, clamped to
+// [1, GOL_MAX_TEMPORAL_STEPS].
+void set_temporal_steps(size_t steps);
+
+__attribute__((pure)) size_t get_temporal_steps(void);
+
+// Keeps the coordinate frame of the dense and iterator engines from one
+// generation to the next instead of centering each new board on the pattern,
+// the block engines always evolve their blocks in place.
+void set_fixed_frame(bool fixed);
+
 void evolve_to_generation_n(size_t generation, struct gol_board *start_gen,
-                            bool verbose, bool iterator);
+                            bool verbose, enum gol_engine engine);
+
+struct gol_history;
+
+// Records the starting board and the board after every pass of
+// evolve_to_generation_n in the history, NULL to stop recording.
+void set_gol_history(struct gol_history *history);
+
+// Restores the newest snapshot of the history taken at or before the
+// generation into the board, then evolves it up to the generation. Returns
+// false when the history does not cover the generation.
+bool rewind_to_generation(size_t generation, struct gol_board *board,
+                          enum gol_engine engine);
 
 #endif // LIFE_H_
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OCCUPANCY_H_
+#define OCCUPANCY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board.h"
+
+// Side of a superblock, in blocks
+#define GOL_SUPERBLOCK 8
+
+// Bit y * GOL_SUPERBLOCK + x of a mask is block (sx * GOL_SUPERBLOCK + x,
+// sy * GOL_SUPERBLOCK + y).
+struct gol_superblock {
+  intmax_t sx, sy;
+  // Blocks holding alive cells
+  uint64_t occupied;
+  // Occupied blocks and their eight neighbours, the only blocks where cells
+  // can be alive during the next generation
+  uint64_t active;
+};
+
+// Summary of the blocks of a board holding alive cells, taken in one pass over
+// its blocks. Only the superblocks with active blocks are listed, so that
+// walking them costs the occupied area of the board, not its bounding box.
+// Changing the board afterwards does not update the summary.
+struct gol_occupancy;
+
+struct gol_occupancy *new_gol_occupancy(const struct gol_board *board);
+
+void free_gol_occupancy(struct gol_occupancy *occupancy);
+
+size_t gol_occupancy_superblocks(const struct gol_occupancy *occupancy,
+                                 const struct gol_superblock **superblocks);
+
+__attribute__((const)) static inline size_t gol_superblock_bit(intmax_t bx,
+                                                               intmax_t by) {
+  return (size_t)(by & (GOL_SUPERBLOCK - 1)) * GOL_SUPERBLOCK +
+         (size_t)(bx & (GOL_SUPERBLOCK - 1));
+}
+
+#endif // OCCUPANCY_H_
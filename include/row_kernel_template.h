@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Row kernel template, included by the block kernel templates.
+// The includer defines:
+//   KERNEL_WORD        type holding the cells of one or more rows
+//   KERNEL_NAME(name)  mangles the name of the generated functions
+//   KERNEL_ATTRIBUTES  function attributes (e.g. the target instruction set)
+
+// Bit-sliced neighbour count: a full adder tree over the eight neighbour
+// words gives, for every cell of the rows at once, the four bits of its number
+// of alive neighbours. Specialized rules get their own boolean expression,
+// unknownRule evaluates the generic rule through a decoder of the count.
+KERNEL_ATTRIBUTES __attribute__((always_inline)) static inline KERNEL_WORD
+KERNEL_NAME(row_next_state)(KERNEL_WORD upW, KERNEL_WORD up, KERNEL_WORD upE,
+                            KERNEL_WORD midW, KERNEL_WORD mid,
+                            KERNEL_WORD midE, KERNEL_WORD downW,
+                            KERNEL_WORD down, KERNEL_WORD downE,
+                            enum gol_rules rule, struct gol_rule generic) {
+  KERNEL_WORD up_sum = upW ^ up ^ upE;
+  KERNEL_WORD up_carry = (upW & up) | (upE & (upW ^ up));
+  KERNEL_WORD down_sum = downW ^ down ^ downE;
+  KERNEL_WORD down_carry = (downW & down) | (downE & (downW ^ down));
+  KERNEL_WORD mid_sum = midW ^ midE;
+  KERNEL_WORD mid_carry = midW & midE;
+
+  KERNEL_WORD ones_carry =
+      (up_sum & down_sum) | (mid_sum & (up_sum ^ down_sum));
+  KERNEL_WORD twos_sum = up_carry ^ down_carry ^ mid_carry;
+  KERNEL_WORD twos_carry =
+      (up_carry & down_carry) | (mid_carry & (up_carry ^ down_carry));
+  KERNEL_WORD fours = twos_sum & ones_carry;
+
+  KERNEL_WORD count0 = up_sum ^ down_sum ^ mid_sum;
+  KERNEL_WORD count1 = twos_sum ^ ones_carry;
+  KERNEL_WORD count2 = twos_carry ^ fours;
+  KERNEL_WORD count3 = twos_carry & fours;
+  KERNEL_WORD two_or_three = (KERNEL_WORD)(count1 & ~count2 & ~count3);
+  switch (rule) {
+  case highLifeRule:
+    return (KERNEL_WORD)((two_or_three & (count0 | mid)) |
+                         (~mid & ~count0 & count1 & count2 & ~count3));
+  case lifeRule:
+    return (KERNEL_WORD)(two_or_three & (count0 | mid));
+  case unknownRule:
+  default: {
+    // Eight neighbours set count3 alone, so only a count of zero checks it.
+    KERNEL_WORD low_count[4] = {
+        (KERNEL_WORD)(~count0 & ~count1 & ~count3),
+        (KERNEL_WORD)(count0 & ~count1), (KERNEL_WORD)(~count0 & count1),
+        (KERNEL_WORD)(count0 & count1)};
+    KERNEL_WORD born = {0}, survives = {0};
+    for (unsigned n = 0; n < 8; ++n) {
+      KERNEL_WORD count_is_n =
+          (KERNEL_WORD)(low_count[n % 4] & (n < 4 ? ~count2 : count2));
+      if ((generic.birth >> n) & 1)
+        born |= count_is_n;
+      if ((generic.survival >> n) & 1)
+        survives |= count_is_n;
+    }
+    if ((generic.birth >> 8) & 1)
+      born |= count3;
+    if ((generic.survival >> 8) & 1)
+      survives |= count3;
+    return (KERNEL_WORD)((mid & survives) | (~mid & born));
+  }
+  }
+}
@@ -37,11 +37,22 @@ set(ADDITIONAL_DEBUG_COMPILE_OPTIONS
   CACHE INTERNAL "String"
   )
 
-set(ADDITIONAL_RELEASE_COMPILE_OPTIONS
-  "-O3"
-  "-march=native"
-  CACHE INTERNAL "String"
-  )
+# The block kernels pick their instruction set at run time, -march=native is
+# only added on request as the resulting binary may not run on other hosts.
+option(USE_NATIVE_ARCH "Optimize the Release build for the host processor" OFF)
+
+if (USE_NATIVE_ARCH)
+  set(ADDITIONAL_RELEASE_COMPILE_OPTIONS
+    "-O3"
+    "-march=native"
+    CACHE INTERNAL "String"
+    )
+else()
+  set(ADDITIONAL_RELEASE_COMPILE_OPTIONS
+    "-O3"
+    CACHE INTERNAL "String"
+    )
+endif()
 
 set(ADDITIONAL_RELEASE_LINK_OPTIONS
   "-Wl,-z,now")
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include "block_kernel.h"
+#include "board.h"
+
+char *gol_isa_string[unknownIsa] = {
+    [isaScalar] = "scalar",
+    [isaSSE2] = "sse2",
+    [isaAVX2] = "avx2",
+    [isaAVX512] = "avx512",
+};
+
+// Holds a block row and its halo for the temporally blocked kernels.
+#if BLOCKSIZE == 64
+__extension__ typedef unsigned __int128 wide_block_type;
+#elif BLOCKSIZE == 32
+typedef uint64_t wide_block_type;
+#elif BLOCKSIZE == 16
+typedef uint32_t wide_block_type;
+#else
+typedef uint16_t wide_block_type;
+#endif
+
+#define KERNEL_WORD block_type
+#define KERNEL_LANES 1
+#define KERNEL_NAME(name) name##_scalar
+#define KERNEL_ATTRIBUTES
+#include "block_kernel_template.h"
+#undef KERNEL_WORD
+#undef KERNEL_LANES
+#undef KERNEL_NAME
+#undef KERNEL_ATTRIBUTES
+
+#define KERNEL_WORD wide_block_type
+#define KERNEL_LANES 1
+#define KERNEL_NAME(name) name##_wide_scalar
+#define KERNEL_ATTRIBUTES
+#include "block_multistep_template.h"
+#undef KERNEL_WORD
+#undef KERNEL_LANES
+#undef KERNEL_NAME
+#undef KERNEL_ATTRIBUTES
+
+// Only the instruction sets faster than the scalar kernels get kernels of
+// their own: 128-bit vectors never beat scalar, and the single step vector
+// kernels of 8x8 blocks, which fit in a 64-bit word, neither.
+#if defined(__x86_64__) || defined(__i386__)
+#define GOL_X86_KERNELS
+
+#if BLOCKSIZE > 8
+#define GOL_X86_BLOCK_KERNELS
+
+typedef block_type avx2_vector __attribute__((vector_size(32)));
+typedef block_type avx512_vector __attribute__((vector_size(64)));
+
+#define KERNEL_WORD avx2_vector
+#define KERNEL_LANES (sizeof(avx2_vector) / sizeof(block_type))
+#define KERNEL_NAME(name) name##_avx2
+#define KERNEL_ATTRIBUTES __attribute__((target("avx2")))
+#include "block_kernel_template.h"
+#undef KERNEL_WORD
+#undef KERNEL_LANES
+#undef KERNEL_NAME
+#undef KERNEL_ATTRIBUTES
+
+#define KERNEL_WORD avx512_vector
+#define KERNEL_LANES (sizeof(avx512_vector) / sizeof(block_type))
+#define KERNEL_NAME(name) name##_avx512
+#define KERNEL_ATTRIBUTES __attribute__((target("avx512f,avx512bw")))
+#include "block_kernel_template.h"
+#undef KERNEL_WORD
+#undef KERNEL_LANES
+#undef KERNEL_NAME
+#undef KERNEL_ATTRIBUTES
+#endif
+
+// There are no vectors of 128-bit integers, 64-cell blocks only get the scalar
+// temporally blocked kernel.
+#if BLOCKSIZE < 64
+#define GOL_X86_MULTISTEP_KERNELS
+
+typedef wide_block_type avx2_wide_vector __attribute__((vector_size(32)));
+typedef wide_block_type avx512_wide_vector __attribute__((vector_size(64)));
+
+#define KERNEL_WORD avx2_wide_vector
+#define KERNEL_LANES (sizeof(avx2_wide_vector) / sizeof(wide_block_type))
+#define KERNEL_NAME(name) name##_wide_avx2
+#define KERNEL_ATTRIBUTES __attribute__((target("avx2")))
+#include "block_multistep_template.h"
+#undef KERNEL_WORD
+#undef KERNEL_LANES
+#undef KERNEL_NAME
+#undef KERNEL_ATTRIBUTES
+
+#define KERNEL_WORD avx512_wide_vector
+#define KERNEL_LANES (sizeof(avx512_wide_vector) / sizeof(wide_block_type))
+#define KERNEL_NAME(name) name##_wide_avx512
+#define KERNEL_ATTRIBUTES __attribute__((target("avx512f,avx512bw")))
+#include "block_multistep_template.h"
+#undef KERNEL_WORD
+#undef KERNEL_LANES
+#undef KERNEL_NAME
+#undef KERNEL_ATTRIBUTES
+#endif
+#endif
+
+#define BLOCK_KERNEL(name, rule, isa) [rule] = evolve_block_##name##_##isa,
+#define MULTISTEP_KERNEL(name, rule, isa)                                      \
+  [rule] = evolve_block_steps_##name##_wide_##isa,
+
+static const gol_block_kernel block_kernels[unknownIsa][unknownRule + 1] = {
+    [isaScalar] = {GOL_RULE_KERNELS(BLOCK_KERNEL, scalar)},
+#ifdef GOL_X86_BLOCK_KERNELS
+    [isaSSE2] = {GOL_RULE_KERNELS(BLOCK_KERNEL, scalar)},
+    [isaAVX2] = {GOL_RULE_KERNELS(BLOCK_KERNEL, avx2)},
+    [isaAVX512] = {GOL_RULE_KERNELS(BLOCK_KERNEL, avx512)},
+#elif defined(GOL_X86_KERNELS)
+    [isaSSE2] = {GOL_RULE_KERNELS(BLOCK_KERNEL, scalar)},
+    [isaAVX2] = {GOL_RULE_KERNELS(BLOCK_KERNEL, scalar)},
+    [isaAVX512] = {GOL_RULE_KERNELS(BLOCK_KERNEL, scalar)},
+#endif
+};
+
+static const gol_multistep_kernel
+    multistep_kernels[unknownIsa][unknownRule + 1] = {
+        [isaScalar] = {GOL_RULE_KERNELS(MULTISTEP_KERNEL, scalar)},
+#ifdef GOL_X86_MULTISTEP_KERNELS
+        [isaSSE2] = {GOL_RULE_KERNELS(MULTISTEP_KERNEL, scalar)},
+        [isaAVX2] = {GOL_RULE_KERNELS(MULTISTEP_KERNEL, avx2)},
+        [isaAVX512] = {GOL_RULE_KERNELS(MULTISTEP_KERNEL, avx512)},
+#elif defined(GOL_X86_KERNELS)
+        [isaSSE2] = {GOL_RULE_KERNELS(MULTISTEP_KERNEL, scalar)},
+        [isaAVX2] = {GOL_RULE_KERNELS(MULTISTEP_KERNEL, scalar)},
+        [isaAVX512] = {GOL_RULE_KERNELS(MULTISTEP_KERNEL, scalar)},
+#endif
+};
+
+#undef BLOCK_KERNEL
+#undef MULTISTEP_KERNEL
+
+static enum gol_isa selected_isa = unknownIsa;
+
+bool gol_isa_supported(enum gol_isa isa) {
+  switch (isa) {
+  case isaScalar:
+    return true;
+#ifdef GOL_X86_KERNELS
+  case isaSSE2:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+  case isaAVX2:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+  case isaAVX512:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f") &&
+           __builtin_cpu_supports("avx512bw");
+#endif
+  default:
+    return false;
+  }
+}
+
+enum gol_isa detect_gol_isa(void) {
+  enum gol_isa best = isaScalar;
+  for (enum gol_isa isa = isaScalar; isa < unknownIsa; ++isa)
+    if (gol_isa_supported(isa))
+      best = isa;
+  return best;
+}
+
+void select_gol_isa(enum gol_isa isa) {
+  selected_isa = gol_isa_supported(isa) ? isa : detect_gol_isa();
+}
+
+enum gol_isa get_gol_isa(void) {
+  if (selected_isa == unknownIsa)
+    selected_isa = detect_gol_isa();
+  return selected_isa;
+}
+
+gol_block_kernel get_block_kernel(struct gol_rule rule) {
+  return block_kernels[get_gol_isa()][gol_rule_kind(rule)];
+}
+
+gol_multistep_kernel get_multistep_kernel(struct gol_rule rule) {
+  return multistep_kernels[get_gol_isa()][gol_rule_kind(rule)];
+}
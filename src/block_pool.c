@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "block_pool.h"
+#include "board.h"
+
+#define CACHE_LINE 64
+#define SLAB_SIZE (2 * 1024 * 1024)
+
+static bool use_huge_pages = false;
+
+void set_huge_pages(bool enable) { use_huge_pages = enable; }
+
+// Smallest power of two holding a block below a cache line, whole cache
+// lines above.
+__attribute__((const)) static inline size_t block_stride(void) {
+  size_t size = sizeof(struct basic_block);
+  if (size >= CACHE_LINE)
+    return (size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+  size_t stride = sizeof(void *);
+  while (stride < size)
+    stride *= 2;
+  return stride;
+}
+
+static void *new_slab(void) {
+  void *slab = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if (use_huge_pages)
+    slab = mmap(NULL, SLAB_SIZE, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+  if (slab == MAP_FAILED) {
+    slab = mmap(NULL, SLAB_SIZE, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (slab == MAP_FAILED)
+      return NULL;
+#ifdef MADV_HUGEPAGE
+    // Transparent huge pages, only a hint
+    if (use_huge_pages)
+      madvise(slab, SLAB_SIZE, MADV_HUGEPAGE);
+#endif
+  }
+  return slab;
+}
+
+void init_block_pool(struct block_pool *pool) {
+  *pool = (struct block_pool){.free_list = NULL,
+                              .next = NULL,
+                              .end = NULL,
+                              .slabs = NULL,
+                              .num_slabs = 0};
+}
+
+struct basic_block *new_pooled_block(struct block_pool *pool) {
+  struct basic_block *bb;
+  if (pool->free_list) {
+    bb = pool->free_list;
+    pool->free_list = *(void **)pool->free_list;
+  } else {
+    size_t stride = block_stride();
+    if (pool->next == NULL || (size_t)(pool->end - pool->next) < stride) {
+      void *slab = new_slab();
+      if (slab == NULL)
+        abort();
+      pool->slabs =
+          realloc(pool->slabs, (pool->num_slabs + 1) * sizeof(*pool->slabs));
+      pool->slabs[pool->num_slabs++] = slab;
+      pool->next = slab;
+      pool->end = pool->next + SLAB_SIZE;
+    }
+    bb = (struct basic_block *)(void *)pool->next;
+    pool->next += stride;
+  }
+  memset(bb, 0, sizeof(*bb));
+  return bb;
+}
+
+void release_pooled_block(struct basic_block *bb, struct block_pool *pool) {
+  *(void **)bb = pool->free_list;
+  pool->free_list = bb;
+}
+
+void free_block_pool(struct block_pool *pool) {
+  for (size_t i = 0; i < pool->num_slabs; ++i)
+    munmap(pool->slabs[i], SLAB_SIZE);
+  free(pool->slabs);
+  init_block_pool(pool);
+}
+
+bool block_pool_oversized(const struct block_pool *pool, size_t num_blocks) {
+  size_t blocks_per_slab = SLAB_SIZE / block_stride();
+  size_t needed = (num_blocks + blocks_per_slab - 1) / blocks_per_slab;
+  return pool->num_slabs > 2 * needed + 1;
+}
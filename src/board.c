@@ -29,59 +29,108 @@
  */
 
 #include <inttypes.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "block_pool.h"
 #include "board.h"
-
-#define uintbis(a) uint##a##_t
-#define uint(a) uintbis(a)
-
-#define uintdefbis(a, b) UINT##a##_C(b)
-#define uintdef(a, b) uintdefbis(a, b)
-#define intdefbis(a, b) INT##a##_C(b)
-#define intdef(a, b) intdefbis(a, b)
+#include "scheduler.h"
 
 #define max(a, b) (((a) > (b)) ? (a) : (b))
 #define min(a, b) (((a) < (b)) ? (a) : (b))
 
-#ifndef BLOCKSIZE
-#define BLOCKSIZE 32
-#endif
-
-#define block_type uint(BLOCKSIZE)
+// Output buffer of dump_board_ASCII
+#define ASCII_BUFFER ((size_t)1 << 20)
 
 char *gol_rule_string[unknownRule] = {
     [lifeRule] = "B3/S23",
     [highLifeRule] = "B36/S23",
 };
 
-struct basic_block {
-  block_type values[BLOCKSIZE];
+const struct gol_rule gol_rule_definition[unknownRule] = {
+    [lifeRule] = {.birth = 1 << 3, .survival = 1 << 2 | 1 << 3},
+    [highLifeRule] = {.birth = 1 << 3 | 1 << 6, .survival = 1 << 2 | 1 << 3},
 };
 
-__attribute__((pure)) static inline bool
-is_empty_block(const struct basic_block *b) {
-  bool continue_search = true;
-  for (size_t i = 0; i < BLOCKSIZE && continue_search; ++i) {
-    continue_search = b->values[i] == uintdef(BLOCKSIZE, 0);
+enum gol_rules gol_rule_kind(struct gol_rule rule) {
+  for (enum gol_rules r = lifeRule; r < unknownRule; ++r)
+    if (gol_rule_definition[r].birth == rule.birth &&
+        gol_rule_definition[r].survival == rule.survival)
+      return r;
+  return unknownRule;
+}
+
+// Reads the digits of a rule part, returns the first character after them.
+static const char *parse_rule_digits(const char *str, uint16_t *counts) {
+  *counts = 0;
+  for (; *str >= '0' && *str <= '8'; ++str)
+    *counts = (uint16_t)(*counts | 1 << (*str - '0'));
+  return str;
+}
+
+bool parse_gol_rule(const char *rulestring, struct gol_rule *rule) {
+  struct gol_rule parsed = {0, 0};
+  const char *str = rulestring;
+  while (*str == ' ' || *str == '\t')
+    ++str;
+  if (*str >= '0' && *str <= '8') {
+    // S/B notation
+    str = parse_rule_digits(str, &parsed.survival);
+    if (*str++ != '/')
+      return false;
+    str = parse_rule_digits(str, &parsed.birth);
+  } else {
+    bool has_birth = false, has_survival = false;
+    for (size_t part = 0; part < 2; ++part) {
+      if ((*str == 'B' || *str == 'b') && !has_birth) {
+        str = parse_rule_digits(str + 1, &parsed.birth);
+        has_birth = true;
+      } else if ((*str == 'S' || *str == 's') && !has_survival) {
+        str = parse_rule_digits(str + 1, &parsed.survival);
+        has_survival = true;
+      } else {
+        return false;
+      }
+      if (part == 0 && *str == '/')
+        ++str;
+    }
   }
-  return continue_search;
+  while (*str == ' ' || *str == '\t' || *str == '\r' || *str == '\n')
+    ++str;
+  if (*str != '\0' || (parsed.birth & 1))
+    return false;
+  *rule = parsed;
+  return true;
+}
+
+void format_gol_rule(struct gol_rule rule, char string[GOL_RULE_STRING_SIZE]) {
+  char *str = string;
+  *str++ = 'B';
+  for (unsigned n = 0; n <= 8; ++n)
+    if ((rule.birth >> n) & 1)
+      *str++ = (char)('0' + n);
+  *str++ = '/';
+  *str++ = 'S';
+  for (unsigned n = 0; n <= 8; ++n)
+    if ((rule.survival >> n) & 1)
+      *str++ = (char)('0' + n);
+  *str = '\0';
 }
 
 __attribute__((pure)) static inline bool
 read_in_block(size_t x, size_t y, const struct basic_block *b) {
-  return b->values[y] & (uintdef(BLOCKSIZE, 1) << x);
+  return gol_block_values(b)[y] & (uintdef(BLOCKSIZE, 1) << x);
 }
 
 static inline void write_in_block(struct basic_block *b, size_t x, size_t y,
                                   bool value) {
   if (value)
-    b->values[y] |= uintdef(BLOCKSIZE, 1) << x;
+    b->planes[b->plane][y] |= (block_type)(uintdef(BLOCKSIZE, 1) << x);
   else
-    b->values[y] &= ~(uintdef(BLOCKSIZE, 1) << x);
+    b->planes[b->plane][y] &= (block_type) ~(uintdef(BLOCKSIZE, 1) << x);
 }
 
 enum bb_direction {
@@ -92,29 +141,86 @@ enum bb_direction {
   bb_all_dirs,
 };
 
+char *gol_board_index_string[unknownIndex] = {
+    [indexSpiral] = "spiral",
+    [indexHash] = "hash",
+    [indexMorton] = "morton",
+};
+
+static enum gol_board_index default_index = indexSpiral;
+
+void set_board_index(enum gol_board_index index) { default_index = index; }
+
+struct block_entry {
+  intmax_t bx, by;
+  struct basic_block *bb;
+};
+
 struct gol_board {
+  enum gol_board_index index;
+  // indexSpiral: the block coordinates are folded into four quadrants, each
+  // numbered along a square spiral starting at its corner. indexMorton: same
+  // for tiles of MORTON_TILE by MORTON_TILE blocks, numbered along the Z-order
+  // curve inside a tile.
   struct basic_block **bb_buffer[bb_all_dirs];
   size_t size_bb_buffer[bb_all_dirs];
+  // indexHash: open addressing with linear probing, entries without block are
+  // free. Never more than half full.
+  struct block_entry *table;
+  size_t size_table;
+  struct block_pool pool;
+  // Every block of the pool, in allocation order
+  struct block_entry *blocks;
+  size_t num_blocks, size_blocks;
   intmax_t offsetX;
   intmax_t offsetY;
   struct gol_board_bounds board_bounds;
-  enum gol_rules rule;
+  struct gol_rule rule;
 };
 
 struct gol_board_iterator {
   struct gol_board *board;
-  enum bb_direction current_bb_dir;
-  size_t current_bb_index;
+  size_t current_block;
   size_t posXinBB, posYinBB;
 };
 
 struct board_position {
-  size_t XPosInbb;
-  size_t YPosInbb;
   size_t bb_offset;
   enum bb_direction direction;
 };
 
+// One tile of pointers spans 8 cache lines
+#define MORTON_TILE 8
+
+// Spreads the low 32 bits of v over the even bits.
+__attribute__((const)) static inline uint64_t spread_bits(uint64_t v) {
+  v &= UINT64_C(0xffffffff);
+  v = (v | v << 16) & UINT64_C(0x0000ffff0000ffff);
+  v = (v | v << 8) & UINT64_C(0x00ff00ff00ff00ff);
+  v = (v | v << 4) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+  v = (v | v << 2) & UINT64_C(0x3333333333333333);
+  v = (v | v << 1) & UINT64_C(0x5555555555555555);
+  return v;
+}
+
+// Inverse of spread_bits.
+__attribute__((const)) static inline uint64_t compact_bits(uint64_t v) {
+  v &= UINT64_C(0x5555555555555555);
+  v = (v | v >> 1) & UINT64_C(0x3333333333333333);
+  v = (v | v >> 2) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+  v = (v | v >> 4) & UINT64_C(0x00ff00ff00ff00ff);
+  v = (v | v >> 8) & UINT64_C(0x0000ffff0000ffff);
+  v = (v | v >> 16) & UINT64_C(0x00000000ffffffff);
+  return v;
+}
+
+// Position along the Z-order curve, the blocks of any aligned square of 2^k
+// by 2^k blocks are contiguous.
+__attribute__((const)) static inline uint64_t morton_code(uint64_t x,
+                                                          uint64_t y) {
+  return spread_bits(x) | spread_bits(y) << 1;
+}
+
 __attribute__((const)) static inline size_t integerSqrt(size_t n) {
   size_t shift = 2;
   size_t nshifted = n >> shift;
@@ -134,93 +240,302 @@ __attribute__((const)) static inline size_t integerSqrt(size_t n) {
   return result;
 }
 
-__attribute__((const)) static inline struct gol_board_iterator_position
-board_to_cartesian_position(struct board_position bp) {
-  size_t quot = integerSqrt(bp.bb_offset);
-  size_t rem = bp.bb_offset - quot * quot;
-  size_t bbYoffset = quot - (rem > quot ? rem - quot : 0);
-  size_t bbXoffset = rem < quot ? rem : quot;
-  struct gol_board_iterator_position position = {
-      .posX = (intmax_t)(bp.XPosInbb + bbXoffset * BLOCKSIZE),
-      .posY = (intmax_t)(bp.YPosInbb + bbYoffset * BLOCKSIZE)};
-  switch (bp.direction) {
-  case bb_se:
-    position.posY = -(position.posY + 1);
-    break;
-  case bb_sw:
-    position.posX = -(position.posX + 1);
-    position.posY = -(position.posY + 1);
-    break;
-  case bb_nw:
-    position.posX = -(position.posX + 1);
-    break;
-  default:
-    break;
-  }
-  return position;
-}
-
+// The cells inside a block are never mirrored, only the block coordinates are
+// folded into one of the four quadrants.
 __attribute__((const)) static inline struct board_position
-position_in_board_structure(intmax_t posX, intmax_t posY) {
+block_in_board_structure(intmax_t bx, intmax_t by,
+                         enum gol_board_index index) {
   struct board_position bp;
   bp.direction = 0;
-  if (posX < 0) {
-    posX = -(posX + 1);
+  if (bx < 0) {
+    bx = -(bx + 1);
     bp.direction += 2;
   }
-  if (posY < 0) {
-    posY = -(posY + 1);
+  if (by < 0) {
+    by = -(by + 1);
     bp.direction++;
   }
-  intmax_t divX = posX / intdef(MAX, BLOCKSIZE);
-  bp.XPosInbb = (size_t)(posX % intdef(MAX, BLOCKSIZE));
-  intmax_t divY = posY / intdef(MAX, BLOCKSIZE);
-  bp.YPosInbb = (size_t)(posY % intdef(MAX, BLOCKSIZE));
-  if (posX < posY) {
-    bp.bb_offset = (size_t)(divY * divY + divX);
+  size_t in_tile = 0;
+  if (index == indexMorton) {
+    in_tile = (size_t)morton_code((uint64_t)bx & (MORTON_TILE - 1),
+                                  (uint64_t)by & (MORTON_TILE - 1));
+    bx /= MORTON_TILE;
+    by /= MORTON_TILE;
+  }
+  if (bx < by) {
+    bp.bb_offset = (size_t)(by * by + bx);
   } else {
-    bp.bb_offset = (size_t)(divX * divX + intdef(MAX, 2) * divX - divY);
+    bp.bb_offset = (size_t)(bx * bx + intdef(MAX, 2) * bx - by);
   }
+  if (index == indexMorton)
+    bp.bb_offset = bp.bb_offset * MORTON_TILE * MORTON_TILE + in_tile;
   return bp;
 }
 
+__attribute__((const)) static inline struct gol_block_position
+block_in_index(enum bb_direction direction, size_t bb_offset,
+               enum gol_board_index index) {
+  size_t in_tile = 0;
+  if (index == indexMorton) {
+    in_tile = bb_offset % (MORTON_TILE * MORTON_TILE);
+    bb_offset /= MORTON_TILE * MORTON_TILE;
+  }
+  size_t quot = integerSqrt(bb_offset);
+  size_t rem = bb_offset - quot * quot;
+  size_t bbYoffset = quot - (rem > quot ? rem - quot : 0);
+  size_t bbXoffset = rem < quot ? rem : quot;
+  if (index == indexMorton) {
+    bbXoffset = bbXoffset * MORTON_TILE + (size_t)compact_bits(in_tile);
+    bbYoffset = bbYoffset * MORTON_TILE + (size_t)compact_bits(in_tile >> 1);
+  }
+  struct gol_block_position position = {.bx = (intmax_t)bbXoffset,
+                                        .by = (intmax_t)bbYoffset};
+  if (direction == bb_nw || direction == bb_sw)
+    position.bx = -(position.bx + 1);
+  if (direction == bb_se || direction == bb_sw)
+    position.by = -(position.by + 1);
+  return position;
+}
+
+__attribute__((const)) static inline size_t table_hash(intmax_t bx,
+                                                       intmax_t by) {
+  uint64_t h = (uint64_t)bx * UINT64_C(0x9e3779b97f4a7c15) ^
+               (uint64_t)by * UINT64_C(0xc2b2ae3d27d4eb4f);
+  return (size_t)(h ^ (h >> 29));
+}
+
+// Entry of the block in the table, or the free entry where it would be.
+__attribute__((pure)) static inline struct block_entry *
+table_entry(const struct gol_board *b, intmax_t bx, intmax_t by) {
+  size_t mask = b->size_table - 1;
+  for (size_t i = table_hash(bx, by) & mask;; i = (i + 1) & mask) {
+    struct block_entry *entry = &b->table[i];
+    if (entry->bb == NULL || (entry->bx == bx && entry->by == by))
+      return entry;
+  }
+}
+
+__attribute__((pure)) static inline struct basic_block *
+find_block(const struct gol_board *b, intmax_t bx, intmax_t by) {
+  if (b->index == indexHash)
+    return b->size_table ? table_entry(b, bx, by)->bb : NULL;
+  struct board_position pos = block_in_board_structure(bx, by, b->index);
+  return b->size_bb_buffer[pos.direction] > pos.bb_offset
+             ? b->bb_buffer[pos.direction][pos.bb_offset]
+             : NULL;
+}
+
 bool read_gol_board(intmax_t posX, intmax_t posY, const struct gol_board *b) {
-  struct board_position pos =
-      position_in_board_structure(posX + b->offsetX, posY + b->offsetY);
-  struct basic_block *bb_to_search =
-      b->size_bb_buffer[pos.direction] > pos.bb_offset
-          ? b->bb_buffer[pos.direction][pos.bb_offset]
-          : NULL;
+  intmax_t x = posX + b->offsetX, y = posY + b->offsetY;
+  intmax_t bx = block_coordinate_x(x), by = block_coordinate_y(y);
+  struct basic_block *bb_to_search = find_block(b, bx, by);
   return bb_to_search != NULL &&
-         read_in_block(pos.XPosInbb, pos.YPosInbb, bb_to_search);
+         read_in_block((size_t)(x - bx * intdef(MAX, BLOCKSIZE)),
+                       (size_t)(y - by * intdef(MAX, BLOCK_HEIGHT)),
+                       bb_to_search);
 }
 
+// Grows geometrically, the new entries are NULL.
 static inline void realloc_bb_buffer(size_t new_size, size_t *current_size,
                                      struct basic_block ***buffer) {
   if (new_size > *current_size) {
-    *buffer = realloc(*buffer, new_size * sizeof(**buffer));
+    new_size = max(new_size, 2 * *current_size);
+    struct basic_block **new_buffer =
+        new_size > SIZE_MAX / sizeof(**buffer)
+            ? NULL
+            : realloc(*buffer, new_size * sizeof(**buffer));
+    if (new_buffer == NULL) {
+      fprintf(stderr, "Cannot index %zu blocks, the pattern is too sparse\n",
+              new_size);
+      exit(EXIT_FAILURE);
+    }
+    *buffer = new_buffer;
     memset(&(*buffer)[*current_size], 0,
            (new_size - *current_size) * sizeof(**buffer));
     *current_size = new_size;
   }
 }
 
-static inline struct basic_block *get_new_empty_bb(struct gol_board *b) {
-  (void)b;
-  struct basic_block *bb = calloc(1, sizeof(*bb));
-  return bb;
+static void resize_table(size_t new_size, struct gol_board *b) {
+  free(b->table);
+  b->table = calloc(new_size, sizeof(*b->table));
+  b->size_table = new_size;
+  for (size_t i = 0; i < b->num_blocks; ++i)
+    *table_entry(b, b->blocks[i].bx, b->blocks[i].by) = b->blocks[i];
+}
+
+static const intmax_t neighbour_dx[allNeighbours] = {-1, 0, 1, -1,
+                                                     1,  -1, 0, 1};
+static const intmax_t neighbour_dy[allNeighbours] = {-1, -1, -1, 0,
+                                                     0,  1,  1,  1};
+
+// New blocks are linked to their neighbours, compact_board unlinks the blocks
+// it releases.
+static struct basic_block *find_or_new_block(intmax_t bx, intmax_t by,
+                                             struct gol_board *b) {
+  struct basic_block **slot;
+  if (b->index == indexHash) {
+    if (2 * (b->num_blocks + 1) > b->size_table)
+      resize_table(max(2 * b->size_table, 64), b);
+    struct block_entry *entry = table_entry(b, bx, by);
+    entry->bx = bx;
+    entry->by = by;
+    slot = &entry->bb;
+  } else {
+    struct board_position pos = block_in_board_structure(bx, by, b->index);
+    realloc_bb_buffer(pos.bb_offset + 1, &b->size_bb_buffer[pos.direction],
+                      &b->bb_buffer[pos.direction]);
+    slot = &b->bb_buffer[pos.direction][pos.bb_offset];
+  }
+  if (*slot == NULL) {
+    if (b->num_blocks == b->size_blocks) {
+      b->size_blocks = max(2 * b->size_blocks, 64);
+      b->blocks = realloc(b->blocks, b->size_blocks * sizeof(*b->blocks));
+    }
+    struct basic_block *bb = new_pooled_block(&b->pool);
+    *slot = bb;
+    b->blocks[b->num_blocks++] =
+        (struct block_entry){.bx = bx, .by = by, .bb = bb};
+    for (enum gol_neighbour k = neighbourNW; k < allNeighbours; ++k) {
+      struct basic_block *neighbour =
+          find_block(b, bx + neighbour_dx[k], by + neighbour_dy[k]);
+      bb->neighbours[k] = neighbour;
+      if (neighbour)
+        neighbour->neighbours[allNeighbours - 1 - k] = bb;
+    }
+  }
+  return *slot;
+}
+
+// Smallest table that does not grow before holding twice the blocks
+__attribute__((const)) static inline size_t table_size_for(size_t num_blocks) {
+  size_t size = 64;
+  while (size < 4 * num_blocks)
+    size *= 2;
+  return size;
+}
+
+// Copies the blocks into a pool of just enough slabs and frees the old one.
+static void move_to_new_pool(struct gol_board *b) {
+  struct block_pool pool;
+  init_block_pool(&pool);
+  for (size_t i = 0; i < b->num_blocks; ++i) {
+    struct block_entry *block = &b->blocks[i];
+    struct basic_block *bb = new_pooled_block(&pool);
+    memcpy(bb, block->bb, sizeof(*bb));
+    block->bb = bb;
+    if (b->index == indexHash) {
+      table_entry(b, block->bx, block->by)->bb = bb;
+    } else {
+      struct board_position pos =
+          block_in_board_structure(block->bx, block->by, b->index);
+      b->bb_buffer[pos.direction][pos.bb_offset] = bb;
+    }
+  }
+  free_block_pool(&b->pool);
+  b->pool = pool;
+  for (size_t i = 0; i < b->num_blocks; ++i) {
+    struct block_entry block = b->blocks[i];
+    for (enum gol_neighbour k = neighbourNW; k < allNeighbours; ++k)
+      block.bb->neighbours[k] = find_block(b, block.bx + neighbour_dx[k],
+                                           block.by + neighbour_dy[k]);
+  }
+}
+
+// The index buffers are only cut down when less than half of them is used,
+// so that a board oscillating around a size does not reallocate them on
+// every compaction.
+static void shrink_bb_buffers(struct gol_board *b) {
+  size_t used[bb_all_dirs] = {0};
+  for (size_t i = 0; i < b->num_blocks; ++i) {
+    struct board_position pos =
+        block_in_board_structure(b->blocks[i].bx, b->blocks[i].by, b->index);
+    used[pos.direction] = max(used[pos.direction], pos.bb_offset + 1);
+  }
+  for (enum bb_direction i = bb_ne; i < bb_all_dirs; ++i) {
+    if (2 * used[i] >= b->size_bb_buffer[i])
+      continue;
+    if (used[i] == 0) {
+      free(b->bb_buffer[i]);
+      b->bb_buffer[i] = NULL;
+    } else {
+      b->bb_buffer[i] =
+          realloc(b->bb_buffer[i], used[i] * sizeof(*b->bb_buffer[i]));
+    }
+    b->size_bb_buffer[i] = used[i];
+  }
+}
+
+// A block that was already empty before the last generation cannot make any
+// of its neighbours change, the evolution treats it as a missing block. The
+// blocks next to alive ones are kept, the block engine would allocate them
+// again right away.
+__attribute__((pure)) static inline bool
+releasable_block(const struct basic_block *bb) {
+  if (!bb->unchanged || !gol_block_empty(bb))
+    return false;
+  for (enum gol_neighbour k = neighbourNW; k < allNeighbours; ++k)
+    if (bb->neighbours[k] && !gol_block_empty(bb->neighbours[k]))
+      return false;
+  return true;
+}
+
+void compact_board(struct gol_board *b) {
+  size_t kept = 0;
+  for (size_t i = 0; i < b->num_blocks; ++i) {
+    struct block_entry block = b->blocks[i];
+    if (!releasable_block(block.bb)) {
+      b->blocks[kept++] = block;
+      continue;
+    }
+    for (enum gol_neighbour k = neighbourNW; k < allNeighbours; ++k)
+      if (block.bb->neighbours[k])
+        block.bb->neighbours[k]->neighbours[allNeighbours - 1 - k] = NULL;
+    // The hash table is rebuilt below, entries cannot be removed from it
+    // without breaking the probing sequences.
+    if (b->index != indexHash) {
+      struct board_position pos =
+          block_in_board_structure(block.bx, block.by, b->index);
+      b->bb_buffer[pos.direction][pos.bb_offset] = NULL;
+    }
+    release_pooled_block(block.bb, &b->pool);
+  }
+  bool released = kept != b->num_blocks;
+  b->num_blocks = kept;
+
+  if (b->index == indexHash) {
+    if (b->num_blocks == 0) {
+      free(b->table);
+      b->table = NULL;
+      b->size_table = 0;
+    } else if (released || b->size_table > table_size_for(b->num_blocks)) {
+      resize_table(table_size_for(b->num_blocks), b);
+    }
+  } else {
+    shrink_bb_buffers(b);
+  }
+  if (b->size_blocks > 4 * b->num_blocks && b->size_blocks > 64) {
+    b->size_blocks = max(2 * b->num_blocks, 64);
+    b->blocks = realloc(b->blocks, b->size_blocks * sizeof(*b->blocks));
+  }
+  if (block_pool_oversized(&b->pool, b->num_blocks))
+    move_to_new_pool(b);
+}
+
+bool board_needs_compaction(const struct gol_board *b) {
+  return block_pool_oversized(&b->pool, b->num_blocks) ||
+         (b->index == indexHash &&
+          b->size_table > 4 * table_size_for(b->num_blocks));
 }
 
 void write_gol_board(intmax_t posX, intmax_t posY, bool val,
                      struct gol_board *b) {
-  struct board_position pos =
-      position_in_board_structure(posX + b->offsetX, posY + b->offsetY);
-  realloc_bb_buffer(pos.bb_offset + 1, &b->size_bb_buffer[pos.direction],
-                    &b->bb_buffer[pos.direction]);
-  if (b->bb_buffer[pos.direction][pos.bb_offset] == NULL)
-    b->bb_buffer[pos.direction][pos.bb_offset] = get_new_empty_bb(b);
-  write_in_block(b->bb_buffer[pos.direction][pos.bb_offset], pos.XPosInbb,
-                 pos.YPosInbb, val);
+  intmax_t x = posX + b->offsetX, y = posY + b->offsetY;
+  intmax_t bx = block_coordinate_x(x), by = block_coordinate_y(y);
+  struct basic_block *bb = find_or_new_block(bx, by, b);
+  write_in_block(bb, (size_t)(x - bx * intdef(MAX, BLOCKSIZE)),
+                 (size_t)(y - by * intdef(MAX, BLOCK_HEIGHT)), val);
+  bb->unchanged = false;
   if (val) {
     b->board_bounds.upperX = max(b->board_bounds.upperX, posX);
     b->board_bounds.lowerX = min(b->board_bounds.lowerX, posX);
@@ -229,21 +544,55 @@ void write_gol_board(intmax_t posX, intmax_t posY, bool val,
   }
 }
 
+void write_gol_board_run(intmax_t posX, intmax_t posY, intmax_t length,
+                         struct gol_board *b) {
+  if (length <= 0)
+    return;
+  intmax_t x = posX + b->offsetX, y = posY + b->offsetY;
+  intmax_t by = block_coordinate_y(y);
+  size_t in_bb_y = (size_t)(y - by * intdef(MAX, BLOCK_HEIGHT));
+  for (intmax_t end = x + length; x < end;) {
+    intmax_t bx = block_coordinate_x(x);
+    size_t first = (size_t)(x - bx * intdef(MAX, BLOCKSIZE));
+    size_t count = (size_t)min(end - x, (intmax_t)(BLOCKSIZE - first));
+    block_type run = (block_type)(count == BLOCKSIZE
+                                      ? ~uintdef(BLOCKSIZE, 0)
+                                      : (uintdef(BLOCKSIZE, 1) << count) - 1);
+    struct basic_block *bb = find_or_new_block(bx, by, b);
+    bb->planes[bb->plane][in_bb_y] |= (block_type)(run << first);
+    bb->unchanged = false;
+    x += (intmax_t)count;
+  }
+  b->board_bounds.upperX = max(b->board_bounds.upperX, posX + length - 1);
+  b->board_bounds.lowerX = min(b->board_bounds.lowerX, posX);
+  b->board_bounds.upperY = max(b->board_bounds.upperY, posY);
+  b->board_bounds.lowerY = min(b->board_bounds.lowerY, posY);
+}
+
 struct gol_board *new_board(void) {
   struct gol_board *board = calloc(1, sizeof(*board));
+  board->index = default_index;
+  init_block_pool(&board->pool);
+  board->board_bounds = GOL_EMPTY_BOUNDS;
+  board->rule = gol_rule_definition[lifeRule];
   return board;
 }
 
 void clean_board(struct gol_board *b) {
-  for (size_t i = 0; i < bb_all_dirs; ++i) {
-    for (size_t j = 0; j < b->size_bb_buffer[i]; ++j) {
-      if (b->bb_buffer[i][j] != NULL) {
-        free(b->bb_buffer[i][j]);
-        b->bb_buffer[i][j] = NULL;
-      }
+  for (size_t i = 0; i < b->num_blocks; ++i) {
+    struct block_entry block = b->blocks[i];
+    release_pooled_block(block.bb, &b->pool);
+    if (b->index != indexHash) {
+      struct board_position pos =
+          block_in_board_structure(block.bx, block.by, b->index);
+      b->bb_buffer[pos.direction][pos.bb_offset] = NULL;
     }
   }
-  memset(&b->board_bounds, 0, sizeof(b->board_bounds));
+  // The table is at most four times as large as the most blocks it held
+  if (b->index == indexHash && b->num_blocks)
+    memset(b->table, 0, b->size_table * sizeof(*b->table));
+  b->num_blocks = 0;
+  b->board_bounds = GOL_EMPTY_BOUNDS;
 }
 
 void free_game(struct gol_game *game) {
@@ -261,24 +610,31 @@ void free_game(struct gol_game *game) {
 void free_board(struct gol_board *b) {
   if (!b)
     return;
-  clean_board(b);
   for (size_t i = 0; i < bb_all_dirs; ++i) {
     free(b->bb_buffer[i]);
   }
+  free(b->table);
+  free_block_pool(&b->pool);
+  free(b->blocks);
   free(b);
 }
 
 struct gol_board_bounds get_game_bounds(const struct gol_board *b) {
+  if (b->board_bounds.lowerX > b->board_bounds.upperX)
+    return (struct gol_board_bounds){0, 0, 0, 0};
   return b->board_bounds;
 }
 
+// The trailing end of line characters of the comment are dropped.
 void add_comment(const char *comment, struct gol_game *b) {
   b->num_comments++;
   b->comments = realloc(b->comments, b->num_comments * sizeof(*b->comments));
   size_t size = strlen(comment);
+  while (size && (comment[size - 1] == '\n' || comment[size - 1] == '\r'))
+    size--;
   b->comments[b->num_comments - 1] = malloc((size + 1) * sizeof(**b->comments));
   memcpy(b->comments[b->num_comments - 1], comment, size);
-  b->comments[b->num_comments - 1][size - 1] = '\0';
+  b->comments[b->num_comments - 1][size] = '\0';
 }
 
 void set_author(const char *authorName, struct gol_game *b) {
@@ -299,16 +655,27 @@ void set_pattern_name(const char *pName, struct gol_game *b) {
   b->patternName[size] = '\0';
 }
 
-void set_game_rules(enum gol_rules rule, struct gol_board *b) {
+void set_game_rules(struct gol_rule rule, struct gol_board *b) {
   b->rule = rule;
 }
 
+void translate_board(intmax_t dx, intmax_t dy, struct gol_board *b) {
+  set_offset(b->offsetX - dx, b->offsetY - dy, b);
+  if (b->board_bounds.lowerX <= b->board_bounds.upperX) {
+    b->board_bounds.lowerX += dx;
+    b->board_bounds.upperX += dx;
+    b->board_bounds.lowerY += dy;
+    b->board_bounds.upperY += dy;
+  }
+}
+
 void set_offset(intmax_t offsetX, intmax_t offsetY, struct gol_board *b) {
   b->offsetX = offsetX;
   b->offsetY = offsetY;
 }
 
-void dump_ASCII(FILE *outStream, struct gol_game *game) {
+void dump_ASCII(FILE *outStream, struct gol_game *game,
+                const struct gol_board_bounds *viewport) {
   if (game->authorName)
     fprintf(outStream, "Author: %s\n", game->authorName);
   if (game->patternName)
@@ -324,16 +691,129 @@ void dump_ASCII(FILE *outStream, struct gol_game *game) {
   if (game->num_comments)
     fprintf(outStream, "\n");
   fprintf(outStream, "Pattern:\n");
-  dump_board_ASCII(outStream, game->board);
+  fflush(outStream);
+  dump_board_ASCII(outStream, game->board, viewport);
 }
 
-void dump_board_ASCII(FILE *outStream, struct gol_board *b) {
-  const struct gol_board_bounds bounds = get_game_bounds(b);
+// The rows are expanded a byte of cells at a time from a table, row by row
+// into a buffer written when full. Blocks are looked up once per row of
+// blocks, the rows of blocks without any block are filled with blanks.
+void dump_board_ASCII(FILE *outStream, const struct gol_board *b,
+                      const struct gol_board_bounds *viewport) {
+  const struct gol_board_bounds bounds =
+      viewport ? *viewport : get_game_bounds(b);
+  char cells[256][8];
+  for (size_t v = 0; v < 256; ++v)
+    for (size_t i = 0; i < 8; ++i)
+      cells[v][i] = (v >> i) & 1 ? 'O' : ' ';
+  intmax_t firstBX = block_coordinate_x(bounds.lowerX + b->offsetX),
+           lastBX = block_coordinate_x(bounds.upperX + b->offsetX);
+  size_t num_row_blocks = (size_t)(lastBX - firstBX + 1);
+  const struct basic_block **row_blocks =
+      malloc(num_row_blocks * sizeof(*row_blocks));
+  // Cells of the whole blocks, the viewport starts at column skip
+  char *line = malloc(num_row_blocks * BLOCKSIZE);
+  size_t skip = (size_t)(bounds.lowerX + b->offsetX - firstBX * BLOCKSIZE);
+  size_t width = (size_t)(bounds.upperX - bounds.lowerX + 1);
+  size_t size_buffer = max(ASCII_BUFFER, width + 1), num_buffered = 0;
+  char *buffer = malloc(size_buffer);
+  bool empty_band = true;
   for (intmax_t j = bounds.lowerY; j <= bounds.upperY; ++j) {
-    for (intmax_t i = bounds.lowerX; i <= bounds.upperX; ++i) {
-      fprintf(outStream, read_gol_board(i, j, b) ? "O" : " ");
+    intmax_t by = block_coordinate_y(j + b->offsetY);
+    size_t in_bb_y = (size_t)(j + b->offsetY - by * intdef(MAX, BLOCK_HEIGHT));
+    if (j == bounds.lowerY || in_bb_y == 0) {
+      empty_band = true;
+      for (size_t k = 0; k < num_row_blocks; ++k) {
+        row_blocks[k] = find_block(b, firstBX + (intmax_t)k, by);
+        empty_band = empty_band && row_blocks[k] == NULL;
+      }
+    }
+    if (num_buffered + width + 1 > size_buffer) {
+      fwrite(buffer, 1, num_buffered, outStream);
+      num_buffered = 0;
+    }
+    char *row_output = buffer + num_buffered;
+    if (empty_band) {
+      memset(row_output, ' ', width);
+    } else {
+      for (size_t k = 0; k < num_row_blocks; ++k) {
+        block_type row =
+            row_blocks[k] ? gol_block_values(row_blocks[k])[in_bb_y] : 0;
+        for (size_t byte = 0; byte < BLOCKSIZE / 8; ++byte)
+          memcpy(&line[k * BLOCKSIZE + 8 * byte],
+                 cells[(row >> (8 * byte)) & 0xff], 8);
+      }
+      memcpy(row_output, &line[skip], width);
+    }
+    row_output[width] = '\n';
+    num_buffered += width + 1;
+  }
+  fwrite(buffer, 1, num_buffered, outStream);
+  free(buffer);
+  free(line);
+  free(row_blocks);
+}
+
+struct board_pair_context {
+  const struct gol_board *b1, *b2;
+  // Block (bx, by) of b1 holds the same cells as block (bx + shiftX,
+  // by + shiftY) of b2
+  intmax_t shiftX, shiftY;
+  atomic_bool differ;
+};
+
+// Items [0, b1->num_blocks) compare the blocks of b1 with the same blocks of
+// b2, the following items check the blocks only present in b2.
+static void same_blocks_task(size_t begin, size_t end, size_t thread,
+                             void *context) {
+  (void)thread;
+  struct board_pair_context *ctx = context;
+  for (size_t n = begin; n < end && !atomic_load(&ctx->differ); ++n) {
+    bool same;
+    if (n < ctx->b1->num_blocks) {
+      struct block_entry block = ctx->b1->blocks[n];
+      const struct basic_block *bb2 =
+          find_block(ctx->b2, block.bx + ctx->shiftX, block.by + ctx->shiftY);
+      same = bb2 ? memcmp(gol_block_values(block.bb), gol_block_values(bb2),
+                          sizeof(bb2->planes[0])) == 0
+                 : gol_block_empty(block.bb);
+    } else {
+      struct block_entry block = ctx->b2->blocks[n - ctx->b1->num_blocks];
+      same = find_block(ctx->b1, block.bx - ctx->shiftX,
+                        block.by - ctx->shiftY) != NULL ||
+             gol_block_empty(block.bb);
+    }
+    if (!same)
+      atomic_store(&ctx->differ, true);
+  }
+}
+
+// Items [0, b1->num_blocks) look for the alive cells of the blocks of b1 in
+// b2, the following items for those of b2 in b1.
+static void same_cells_task(size_t begin, size_t end, size_t thread,
+                            void *context) {
+  (void)thread;
+  struct board_pair_context *ctx = context;
+  for (size_t n = begin; n < end && !atomic_load(&ctx->differ); ++n) {
+    const struct gol_board *from = ctx->b1, *to = ctx->b2;
+    if (n >= ctx->b1->num_blocks) {
+      from = ctx->b2;
+      to = ctx->b1;
+    }
+    struct block_entry block =
+        from->blocks[n < ctx->b1->num_blocks ? n : n - ctx->b1->num_blocks];
+    const block_type *values = gol_block_values(block.bb);
+    for (size_t y = 0; y < BLOCK_HEIGHT; ++y) {
+      for (block_type row = values[y]; row; row &= (block_type)(row - 1)) {
+        intmax_t i = block.bx * BLOCKSIZE +
+                     (intmax_t)block_lowest_bit(row) - from->offsetX,
+                 j = block.by * BLOCK_HEIGHT + (intmax_t)y - from->offsetY;
+        if (!read_gol_board(i, j, to)) {
+          atomic_store(&ctx->differ, true);
+          return;
+        }
+      }
     }
-    fprintf(outStream, "\n");
   }
 }
 
@@ -345,77 +825,66 @@ bool gol_same_board(const struct gol_board *b1, const struct gol_board *b2) {
       b1bounds.lowerX != b2bounds.lowerX ||
       b1bounds.upperY != b2bounds.upperY || b1bounds.lowerY != b2bounds.lowerY)
     return false;
-  if (b1->offsetX == b2->offsetX && b1->offsetY == b2->offsetY) {
-    for (size_t i = 0; i < bb_all_dirs; ++i) {
-      for (size_t j = 0; j < min(b1->size_bb_buffer[i], b2->size_bb_buffer[i]);
-           ++j) {
-        struct basic_block *bb1 = b1->bb_buffer[i][j];
-        struct basic_block *bb2 = b2->bb_buffer[i][j];
-        if (bb1 && !bb2) {
-          if (!is_empty_block(bb1))
-            return false;
-        } else if (!bb1 && bb2) {
-          if (!is_empty_block(bb2))
-            return false;
-        } else if (bb2) {
-          int retval = memcmp(bb1->values, bb2->values, sizeof(bb1->values));
-          if (retval != 0)
-            return false;
-        }
-      }
-    }
+  struct board_pair_context context = {.b1 = b1, .b2 = b2};
+  atomic_init(&context.differ, false);
+  // The blocks of both boards hold the same cells whenever their offsets are
+  // a whole number of blocks apart.
+  intmax_t dx = b2->offsetX - b1->offsetX, dy = b2->offsetY - b1->offsetY;
+  if (dx % intdef(MAX, BLOCKSIZE) == 0 &&
+      dy % intdef(MAX, BLOCK_HEIGHT) == 0) {
+    context.shiftX = dx / intdef(MAX, BLOCKSIZE);
+    context.shiftY = dy / intdef(MAX, BLOCK_HEIGHT);
+    gol_parallel_for(b1->num_blocks + b2->num_blocks, 256, same_blocks_task,
+                     &context);
   } else {
-    for (intmax_t i = b1bounds.lowerX; i <= b1bounds.upperX; ++i) {
-      for (intmax_t j = b1bounds.lowerY; j <= b1bounds.upperY; ++j) {
-        if (read_gol_board(i, j, b1) != read_gol_board(i, j, b2))
-          return false;
-      }
-    }
+    gol_parallel_for(b1->num_blocks + b2->num_blocks, 64, same_cells_task,
+                     &context);
   }
-  return true;
+  return !atomic_load(&context.differ);
+}
+
+struct block_copy {
+  const struct basic_block *from;
+  struct basic_block *to;
+};
+
+static void copy_blocks_task(size_t begin, size_t end, size_t thread,
+                             void *context) {
+  (void)thread;
+  struct block_copy *copies = context;
+  for (size_t i = begin; i < end; ++i)
+    memcpy(copies[i].to->planes[copies[i].to->plane],
+           gol_block_values(copies[i].from), sizeof(copies[i].to->planes[0]));
 }
 
 void gol_copy_board(const struct gol_board *to_copy, struct gol_board *copy) {
   clean_board(copy);
-  copy->board_bounds = get_game_bounds(to_copy);
+  copy->board_bounds = to_copy->board_bounds;
   set_offset(to_copy->offsetX, to_copy->offsetY, copy);
   set_game_rules(get_game_rules(to_copy), copy);
-  for (size_t i = 0; i < bb_all_dirs; ++i) {
-    for (size_t j = to_copy->size_bb_buffer[i] - 1;
-         j < to_copy->size_bb_buffer[i]; --j) {
-      struct basic_block *bb_to_copy = to_copy->bb_buffer[i][j];
-      if (bb_to_copy != NULL && !is_empty_block(bb_to_copy)) {
-        struct basic_block *bb_copy = get_new_empty_bb(copy);
-        memcpy(bb_copy->values, bb_to_copy->values, sizeof(bb_copy->values));
-        realloc_bb_buffer(j + 1, &copy->size_bb_buffer[i], &copy->bb_buffer[i]);
-        copy->bb_buffer[i][j] = bb_copy;
-      }
-    }
+  struct block_copy *copies =
+      malloc(max(to_copy->num_blocks, 1) * sizeof(*copies));
+  size_t num_copies = 0;
+  for (size_t i = 0; i < to_copy->num_blocks; ++i) {
+    struct block_entry block = to_copy->blocks[i];
+    if (!gol_block_empty(block.bb))
+      copies[num_copies++] = (struct block_copy){
+          .from = block.bb, .to = find_or_new_block(block.bx, block.by, copy)};
   }
+  gol_parallel_for(num_copies, 256, copy_blocks_task, copies);
+  free(copies);
 }
 
+// The rules stay with their boards.
 void gol_swap_board(struct gol_board *swap1, struct gol_board *swap2) {
-  for (enum bb_direction i = bb_ne; i < bb_all_dirs; ++i) {
-    size_t size_bb_tmp;
-    struct basic_block **tmp;
-    tmp = swap1->bb_buffer[i];
-    swap1->bb_buffer[i] = swap2->bb_buffer[i];
-    swap2->bb_buffer[i] = tmp;
-    size_bb_tmp = swap1->size_bb_buffer[i];
-    swap1->size_bb_buffer[i] = swap2->size_bb_buffer[i];
-    swap2->size_bb_buffer[i] = size_bb_tmp;
-  }
-  struct gol_board_bounds tmp_bounds = get_game_bounds(swap1);
-  swap1->board_bounds = get_game_bounds(swap2);
-  swap2->board_bounds = tmp_bounds;
-  intmax_t tmp_OffsetX[2], tmpOffsetY[2];
-  get_offset(swap1, &tmp_OffsetX[0], &tmpOffsetY[0]);
-  get_offset(swap2, &tmp_OffsetX[1], &tmpOffsetY[1]);
-  set_offset(tmp_OffsetX[1], tmpOffsetY[1], swap1);
-  set_offset(tmp_OffsetX[0], tmpOffsetY[0], swap2);
-}
-
-enum gol_rules get_game_rules(const struct gol_board *b) { return b->rule; }
+  struct gol_board tmp = *swap1;
+  *swap1 = *swap2;
+  *swap2 = tmp;
+  swap2->rule = swap1->rule;
+  swap1->rule = tmp.rule;
+}
+
+struct gol_rule get_game_rules(const struct gol_board *b) { return b->rule; }
 
 void clone_metadata(const struct gol_game *b1, struct gol_game *b2) {
   set_author(b1->authorName, b2);
@@ -432,77 +901,145 @@ void get_offset(const struct gol_board *board, intmax_t *offsetX,
 }
 
 struct gol_board_iterator* board_iterator_start(struct gol_board *b) {
-  struct gol_board_iterator it = {.board = b,
-                                  .current_bb_dir = bb_ne,
-                                  .current_bb_index = 0,
-                                  .posXinBB = 0,
-                                  .posYinBB = 0};
+  struct gol_board_iterator it = {
+      .board = b, .current_block = 0, .posXinBB = 0, .posYinBB = 0};
   struct gol_board_iterator *iterator = malloc(sizeof(*iterator));
   *iterator = it;
-  if (read_gol_board(b->offsetX, b->offsetY, b))
+  if (board_iterator_is_end(iterator) ||
+      read_in_block(0, 0, b->blocks[0].bb))
     return iterator;
   else
     return board_iterator_next(iterator);
 }
 
 bool board_iterator_is_end(struct gol_board_iterator *it) {
-  return it->current_bb_dir == bb_all_dirs;
+  return it->current_block == it->board->num_blocks;
 }
 
+// The cells of a block are visited row by row, the alive cells of a row are
+// found from its bits.
 struct gol_board_iterator* board_iterator_next(struct gol_board_iterator *it) {
-  bool continue_from_iterator = true;
-  for (enum bb_direction dir = it->current_bb_dir; dir < bb_all_dirs; ++dir) {
-    if (continue_from_iterator && it->current_bb_dir != dir)
-      continue_from_iterator = false;
-    size_t bb_start_index = continue_from_iterator ? it->current_bb_index : 0;
-    for (size_t bb_index = bb_start_index;
-         bb_index < it->board->size_bb_buffer[dir]; ++bb_index) {
-      if (it->board->bb_buffer[dir][bb_index] == NULL)
-        continue;
-      if (continue_from_iterator && bb_index != it->current_bb_index)
-        continue_from_iterator = false;
-      size_t in_bb_startX = continue_from_iterator ? it->posXinBB : 0;
-      for (size_t i = in_bb_startX; i < BLOCKSIZE; ++i) {
-        if (continue_from_iterator && i != it->posXinBB)
-          continue_from_iterator = false;
-        size_t in_bb_startY = continue_from_iterator ? it->posYinBB + 1 : 0;
-        for (size_t j = in_bb_startY; j < BLOCKSIZE; ++j) {
-          if (read_in_block(i, j, it->board->bb_buffer[dir][bb_index])) {
-            it->current_bb_dir = dir;
-            it->current_bb_index = bb_index;
-            it->posXinBB = i;
-            it->posYinBB = j;
-            return it;
-          }
-        }
+  size_t x = it->posXinBB + 1, y = it->posYinBB;
+  for (size_t n = it->current_block; n < it->board->num_blocks;
+       ++n, x = 0, y = 0) {
+    const block_type *values = gol_block_values(it->board->blocks[n].bb);
+    for (; y < BLOCK_HEIGHT; ++y, x = 0) {
+      block_type row = 0;
+      if (x < BLOCKSIZE)
+        row = (block_type)(values[y] >> x << x);
+      if (row) {
+        it->current_block = n;
+        it->posXinBB = block_lowest_bit(row);
+        it->posYinBB = y;
+        return it;
       }
     }
   }
-  it->current_bb_dir = bb_all_dirs;
+  it->current_block = it->board->num_blocks;
   return it;
 }
 
 struct gol_board_iterator_position
 board_iterator_position(struct gol_board_iterator *iter) {
-  struct board_position bp = {.XPosInbb = iter->posXinBB,
-                              .YPosInbb = iter->posYinBB,
-                              .bb_offset = iter->current_bb_index,
-                              .direction = iter->current_bb_dir};
-  struct gol_board_iterator_position pos = board_to_cartesian_position(bp);
-  pos.posX -= iter->board->offsetX;
-  pos.posY -= iter->board->offsetY;
+  struct block_entry block = iter->board->blocks[iter->current_block];
+  struct gol_board_iterator_position pos = {
+      .posX = (intmax_t)iter->posXinBB + block.bx * BLOCKSIZE -
+              iter->board->offsetX,
+      .posY = (intmax_t)iter->posYinBB + block.by * BLOCK_HEIGHT -
+              iter->board->offsetY};
   return pos;
 }
 
 bool board_iterator_equal(struct gol_board_iterator *it1,
                           struct gol_board_iterator *it2) {
-  return (it1->current_bb_dir == it2->current_bb_dir &&
-          it1->current_bb_dir == bb_all_dirs) ||
-         (it1->current_bb_dir == it2->current_bb_dir && it1->board == it2->board &&
-          it1->current_bb_index && it2->current_bb_index &&
-          it1->posXinBB == it2->posXinBB && it1->posYinBB == it2->posYinBB);
+  return it1->board == it2->board && it1->current_block == it2->current_block &&
+         (board_iterator_is_end(it1) || (it1->posXinBB == it2->posXinBB &&
+                                         it1->posYinBB == it2->posYinBB));
 }
 
 void board_iterator_free(struct gol_board_iterator *it) {
   free(it);
 }
+
+struct basic_block *get_gol_block(intmax_t bx, intmax_t by,
+                                  const struct gol_board *b) {
+  return find_block(b, bx, by);
+}
+
+struct basic_block *get_or_new_gol_block(intmax_t bx, intmax_t by,
+                                         struct gol_board *b) {
+  return find_or_new_block(bx, by, b);
+}
+
+bool gol_block_bounds(const struct basic_block *bb, intmax_t originX,
+                      intmax_t originY, struct gol_board_bounds *bounds) {
+  block_type columns = 0;
+  size_t first_row = BLOCK_HEIGHT, last_row = 0;
+  const block_type *values = gol_block_values(bb);
+  for (size_t i = 0; i < BLOCK_HEIGHT; ++i) {
+    if (values[i]) {
+      first_row = min(first_row, i);
+      last_row = i;
+      columns |= values[i];
+    }
+  }
+  if (columns == 0)
+    return false;
+  bounds->lowerX = originX + (intmax_t)block_lowest_bit(columns);
+  bounds->upperX = originX + (intmax_t)block_highest_bit(columns);
+  bounds->lowerY = originY + (intmax_t)first_row;
+  bounds->upperY = originY + (intmax_t)last_row;
+  return true;
+}
+
+void set_game_bounds(const struct gol_board_bounds *bounds,
+                     struct gol_board *b) {
+  b->board_bounds = *bounds;
+}
+
+size_t gol_board_num_blocks(const struct gol_board *b) { return b->num_blocks; }
+
+struct basic_block *gol_board_block(const struct gol_board *b, size_t n,
+                                    intmax_t *bx, intmax_t *by) {
+  *bx = b->blocks[n].bx;
+  *by = b->blocks[n].by;
+  return b->blocks[n].bb;
+}
+
+void extend_game_bounds(const struct gol_board_bounds *bounds,
+                        struct gol_board *b) {
+  b->board_bounds.lowerX = min(b->board_bounds.lowerX, bounds->lowerX);
+  b->board_bounds.upperX = max(b->board_bounds.upperX, bounds->upperX);
+  b->board_bounds.lowerY = min(b->board_bounds.lowerY, bounds->lowerY);
+  b->board_bounds.upperY = max(b->board_bounds.upperY, bounds->upperY);
+}
+
+size_t list_gol_blocks(const struct gol_board *b,
+                       struct gol_block_position **positions) {
+  *positions = malloc(max(b->num_blocks, 1) * sizeof(**positions));
+  size_t num_blocks = 0;
+  if (b->index == indexMorton) {
+    // Tile by tile, the spiral position of the tile is only decoded once
+    const size_t tile_size = MORTON_TILE * MORTON_TILE;
+    for (enum bb_direction i = bb_ne; i < bb_all_dirs; ++i) {
+      for (size_t tile = 0; tile < b->size_bb_buffer[i]; tile += tile_size) {
+        struct gol_block_position origin = block_in_index(i, tile, indexMorton);
+        intmax_t signX = origin.bx < 0 ? -1 : 1, signY = origin.by < 0 ? -1 : 1;
+        for (size_t j = tile; j < min(tile + tile_size, b->size_bb_buffer[i]);
+             ++j)
+          if (b->bb_buffer[i][j] != NULL &&
+              !gol_block_empty(b->bb_buffer[i][j]))
+            (*positions)[num_blocks++] = (struct gol_block_position){
+                .bx = origin.bx + signX * (intmax_t)compact_bits(j - tile),
+                .by = origin.by +
+                      signY * (intmax_t)compact_bits((j - tile) >> 1)};
+      }
+    }
+  } else {
+    for (size_t i = 0; i < b->num_blocks; ++i)
+      if (!gol_block_empty(b->blocks[i].bb))
+        (*positions)[num_blocks++] = (struct gol_block_position){
+            .bx = b->blocks[i].bx, .by = b->blocks[i].by};
+  }
+  return num_blocks;
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cycle.h"
+
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+
+#define HASH_A UINT64_C(0x9e3779b97f4a7c15)
+#define HASH_B UINT64_C(0xc2b2ae3d27d4eb4f)
+
+#define CYCLE_HISTORY 256
+
+// byte_hash[v] is the sum of A^i over the bits i set in v, shifted_byte[k] is
+// A^(8k) to place the byte k of a row.
+static uint64_t byte_hash[256];
+static uint64_t shifted_byte[(BLOCKSIZE + 7) / 8];
+static uint64_t inverse_A, inverse_B;
+static bool hash_tables_ready = false;
+
+// Newton's iteration, each step doubles the number of correct low bits.
+__attribute__((const)) static uint64_t inverse(uint64_t odd) {
+  uint64_t inv = odd;
+  for (size_t i = 0; i < 5; ++i)
+    inv *= 2 - odd * inv;
+  return inv;
+}
+
+__attribute__((const)) static uint64_t power(uint64_t base, uint64_t inverse_base,
+                                             intmax_t exponent) {
+  uint64_t e = (uint64_t)exponent;
+  if (exponent < 0) {
+    base = inverse_base;
+    e = -e;
+  }
+  uint64_t result = 1;
+  for (; e; e >>= 1) {
+    if (e & 1)
+      result *= base;
+    base *= base;
+  }
+  return result;
+}
+
+static void init_hash_tables(void) {
+  if (hash_tables_ready)
+    return;
+  uint64_t bit_power[8];
+  bit_power[0] = 1;
+  for (size_t i = 1; i < 8; ++i)
+    bit_power[i] = bit_power[i - 1] * HASH_A;
+  for (size_t v = 0; v < 256; ++v) {
+    byte_hash[v] = 0;
+    for (size_t i = 0; i < 8; ++i)
+      if ((v >> i) & 1)
+        byte_hash[v] += bit_power[i];
+  }
+  shifted_byte[0] = 1;
+  for (size_t k = 1; k < sizeof(shifted_byte) / sizeof(*shifted_byte); ++k)
+    shifted_byte[k] = shifted_byte[k - 1] * bit_power[7] * HASH_A;
+  inverse_A = inverse(HASH_A);
+  inverse_B = inverse(HASH_B);
+  hash_tables_ready = true;
+}
+
+uint64_t gol_block_hash(const struct basic_block *bb, intmax_t x, intmax_t y) {
+  uint64_t hash = 0;
+  const block_type *values = gol_block_values(bb);
+  for (size_t j = BLOCK_HEIGHT - 1; j < BLOCK_HEIGHT; --j) {
+    uint64_t row = 0;
+    for (block_type v = values[j], k = 0; v; v = (block_type)(v >> 8), ++k)
+      row += shifted_byte[k] * byte_hash[v & 0xff];
+    hash = hash * HASH_B + row;
+  }
+  if (hash == 0)
+    return 0;
+  return hash * power(HASH_A, inverse_A, x) * power(HASH_B, inverse_B, y);
+}
+
+uint64_t gol_canonical_hash(uint64_t hash, struct gol_board_bounds bounds) {
+  return hash * power(HASH_A, inverse_A, -bounds.lowerX) *
+         power(HASH_B, inverse_B, -bounds.lowerY);
+}
+
+// Canonical hashes of the boards after the last passes. A hash equal to the
+// one of `period` generations ago makes the board, moved by the difference of
+// their bounds, a candidate for the board `period` generations later.
+struct gol_cycle_detector {
+  uint64_t hashes[CYCLE_HISTORY];
+  size_t generations[CYCLE_HISTORY];
+  intmax_t lowerX[CYCLE_HISTORY], lowerY[CYCLE_HISTORY];
+  size_t num_hashes;
+  struct gol_board *candidate;
+  size_t candidate_generation, candidate_period;
+  intmax_t candidate_dx, candidate_dy;
+  bool found;
+};
+
+struct gol_cycle_detector *new_cycle_detector(void) {
+  init_hash_tables();
+  struct gol_cycle_detector *cd = calloc(1, sizeof(*cd));
+  return cd;
+}
+
+void free_cycle_detector(struct gol_cycle_detector *cd) {
+  if (cd->candidate)
+    free_board(cd->candidate);
+  free(cd);
+}
+
+size_t detect_cycle(struct gol_cycle_detector *cd, struct gol_board *board,
+                    uint64_t hash, size_t current, size_t generation,
+                    bool verbose) {
+  if (cd->found)
+    return 0;
+  if (cd->candidate &&
+      current >= cd->candidate_generation + cd->candidate_period) {
+    bool same = current == cd->candidate_generation + cd->candidate_period &&
+                gol_same_board(board, cd->candidate);
+    free_board(cd->candidate);
+    cd->candidate = NULL;
+    if (same) {
+      cd->found = true;
+      size_t period = cd->candidate_period;
+      size_t cycles = (generation - current) / period;
+      if (verbose) {
+        if (cd->candidate_dx == 0 && cd->candidate_dy == 0)
+          printf("\rPeriod %zu found at generation %zu\n", period,
+                 cd->candidate_generation);
+        else
+          printf("\rPeriod %zu moving by (%jd, %jd) found at generation %zu\n",
+                 period, cd->candidate_dx, cd->candidate_dy,
+                 cd->candidate_generation);
+      }
+      translate_board((intmax_t)cycles * cd->candidate_dx,
+                      (intmax_t)cycles * cd->candidate_dy, board);
+      return cycles * period;
+    }
+  }
+  struct gol_board_bounds bounds = get_game_bounds(board);
+  uint64_t canonical = gol_canonical_hash(hash, bounds);
+  size_t newest = cd->num_hashes;
+  size_t history = min(cd->num_hashes, (size_t)CYCLE_HISTORY);
+  for (size_t k = 1; k <= history && !cd->candidate; ++k) {
+    size_t slot = (newest - k) % CYCLE_HISTORY;
+    if (cd->hashes[slot] == canonical) {
+      cd->candidate_generation = current;
+      cd->candidate_period = current - cd->generations[slot];
+      cd->candidate_dx = bounds.lowerX - cd->lowerX[slot];
+      cd->candidate_dy = bounds.lowerY - cd->lowerY[slot];
+      cd->candidate = new_board();
+      gol_copy_board(board, cd->candidate);
+      translate_board(cd->candidate_dx, cd->candidate_dy, cd->candidate);
+    }
+  }
+  cd->hashes[newest % CYCLE_HISTORY] = canonical;
+  cd->generations[newest % CYCLE_HISTORY] = current;
+  cd->lowerX[newest % CYCLE_HISTORY] = bounds.lowerX;
+  cd->lowerY[newest % CYCLE_HISTORY] = bounds.lowerY;
+  cd->num_hashes++;
+  return 0;
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "geometry.h"
+
+const struct option gol_long_options[] = {
+    {"help", no_argument, 0, 'h'},
+    {"verbose", no_argument, 0, 'v'},
+    {"output", required_argument, 0, 'o'},
+    {"compare-rle", required_argument, 0, 'c'},
+    {"generation", required_argument, 0, 'g'},
+    {"force-life", no_argument, 0, 'l'},
+    {"force-highlife", no_argument, 0, 'L'},
+    {"rule", required_argument, 0, 'r'},
+    {"ascii-output", no_argument, 0, 'a'},
+    {"iterator", no_argument, 0, 'i'},
+    {"engine", required_argument, 0, 'e'},
+    {"isa", required_argument, 0, 's'},
+    {"threads", required_argument, 0, 't'},
+    {"temporal-steps", required_argument, 0, 'k'},
+    {"huge-pages", no_argument, 0, 'm'},
+    {"index", required_argument, 0, 'x'},
+    {"block", required_argument, 0, 'b'},
+    {"history", required_argument, 0, 'H'},
+    {"rewind", required_argument, 0, 'w'},
+    {"fixed-frame", no_argument, 0, 'f'},
+    {"viewport", required_argument, 0, 'V'},
+    {0, 0, 0, 0}};
+
+const char gol_short_options[] = ":ho:c:g:lLr:avie:s:t:k:mx:b:H:w:fV:";
+
+#define GOL_GEOMETRY_ENTRY(width, height)                                      \
+  {#width "x" #height, run_gol_##width##x##height},
+static const struct {
+  const char *name;
+  int (*run)(int argc, char **argv);
+} geometries[] = {GOL_GEOMETRIES(GOL_GEOMETRY_ENTRY)};
+#undef GOL_GEOMETRY_ENTRY
+
+static const size_t num_geometries = sizeof(geometries) / sizeof(geometries[0]);
+
+bool gol_has_extension(const char *file_name, const char *extension) {
+  size_t name_length = strlen(file_name), length = strlen(extension);
+  return name_length >= length &&
+         strcmp(file_name + name_length - length, extension) == 0;
+}
+
+// Bytes of the cell grid of a RLE file read to estimate its population.
+#define RLE_POPULATION_SAMPLE (1 << 16)
+
+// Estimates the live cells of a RLE file without building the board: the
+// population of the first RLE_POPULATION_SAMPLE bytes of the cell grid is
+// scaled to the size of the file, and bounded by the area of the header.
+// Returns false if the file cannot be read.
+static bool rle_population(const char *file_name, uintmax_t *population) {
+  FILE *file = fopen(file_name, "r");
+  if (file == NULL)
+    return false;
+  uintmax_t width, height;
+  char line[1024];
+  bool header = false;
+  while (!header && fgets(line, sizeof(line), file) != NULL)
+    header = line[0] != '#' &&
+             sscanf(line, " x = %ju , y = %ju", &width, &height) == 2;
+  long grid = ftell(file);
+  *population = 0;
+  uintmax_t run = 0, sampled = 0;
+  int c;
+  bool end = false;
+  while (header && sampled < RLE_POPULATION_SAMPLE &&
+         !(end = (c = fgetc(file)) == EOF || c == '!')) {
+    sampled++;
+    if (isdigit(c)) {
+      run = run * 10 + (uintmax_t)(c - '0');
+    } else if (isalpha(c) || c == '$') {
+      if (isalpha(c) && c != 'b')
+        *population += run == 0 ? 1 : run;
+      run = 0;
+    }
+  }
+  if (header && !end && fseek(file, 0, SEEK_END) == 0 && grid >= 0 &&
+      sampled > 0) {
+    long size = ftell(file);
+    if (size > grid)
+      *population = (uintmax_t)((double)*population * (double)(size - grid) /
+                                (double)sampled);
+    if (width != 0 && height <= UINTMAX_MAX / width)
+      *population = *population < width * height ? *population : width * height;
+  }
+  fclose(file);
+  return header;
+}
+
+// The cost of a block is dominated by its bookkeeping rather than by its
+// cells, so rows are 64 cells wide. Square blocks above about 32k live cells,
+// short ones waste less work around the smaller patterns.
+#define GOL_LARGE_PATTERN 32768
+
+// Macrocell files hold the patterns too large for RLE files.
+static const char *geometry_from_population(const char *file_name) {
+  if (gol_has_extension(file_name, ".mc"))
+    return "64x64";
+  uintmax_t population;
+  if (!rle_population(file_name, &population))
+    return geometries[0].name;
+  return population >= GOL_LARGE_PATTERN ? "64x64" : "64x16";
+}
+
+int main(int argc, char **argv) {
+  const char *geometry = "auto";
+  const char *engine = "block";
+  const char *input_file_name = NULL;
+  opterr = 0;
+  while (true) {
+    int optchar =
+        getopt_long(argc, argv, gol_short_options, gol_long_options, NULL);
+    if (optchar == -1)
+      break;
+    if (optchar == 'b')
+      geometry = optarg;
+    if (optchar == 'e')
+      engine = optarg;
+  }
+  if (optind == argc - 1)
+    input_file_name = argv[optind];
+  // Restarts getopt for run_gol
+  optind = 0;
+  opterr = 1;
+
+  // The temporal engine only gets its largest halos below 64 cells wide rows,
+  // see GOL_DEFAULT_TEMPORAL_STEPS.
+  if (strcmp(geometry, "auto") == 0 && strcmp(engine, "temporal") == 0)
+    geometry = "32x32";
+  if (strcmp(geometry, "auto") == 0)
+    geometry = input_file_name ? geometry_from_population(input_file_name)
+                               : geometries[0].name;
+  for (size_t i = 0; i < num_geometries; ++i)
+    if (strcmp(geometry, geometries[i].name) == 0)
+      return geometries[i].run(argc, argv);
+  fprintf(stderr, "Unknown block geometry \"%s\", available:", geometry);
+  for (size_t i = 0; i < num_geometries; ++i)
+    fprintf(stderr, " %s", geometries[i].name);
+  fprintf(stderr, "\n");
+  return EXIT_FAILURE;
+}
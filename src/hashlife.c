@@ -0,0 +1,563 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "board.h"
+#include "hashlife.h"
+
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+
+// Nodes allocated before a garbage collection drops the unreachable nodes and
+// the memoized results. The bound grows to twice the reachable nodes when they
+// alone exceed it.
+#ifndef HASHLIFE_MAX_NODES
+#define HASHLIFE_MAX_NODES (UINT64_C(1) << 22)
+#endif
+
+#define HASHLIFE_MAX_LEVEL 62
+#define HASHLIFE_NODE_CHUNK 4096
+// Side of the largest square node inside a block
+#define LOG2_BLOCKSIZE ((unsigned)__builtin_ctz(BLOCK_HEIGHT))
+
+enum hl_quadrant {
+  hl_nw = 0,
+  hl_ne,
+  hl_sw,
+  hl_se,
+  hl_all_quadrants,
+};
+
+// A level k node is a 2^k x 2^k square, level 0 nodes are single cells.
+struct hl_node {
+  struct hl_node *child[hl_all_quadrants];
+  // Center advanced by 2^(level-2) generations
+  struct hl_node *result;
+  // Center advanced by 2^step generations, for steps smaller than the above
+  struct hl_node *step_result;
+  struct hl_node *hash_next;
+  uint64_t population;
+  unsigned level;
+  unsigned step;
+  bool marked;
+};
+
+struct hashlife {
+  struct hl_node **buckets;
+  size_t num_buckets;
+  size_t num_nodes;
+  struct hl_node **chunks;
+  size_t num_chunks;
+  size_t chunk_used;
+  struct hl_node *free_list;
+  struct hl_node *empty[HASHLIFE_MAX_LEVEL + 1];
+  struct hl_node leaves[2];
+  struct gol_rule rule;
+  size_t max_nodes;
+  // Nodes held by the advances in progress, kept by the garbage collections
+  struct hl_node **stack;
+  size_t stack_size, stack_capacity;
+};
+
+static void push_node(struct hashlife *hl, struct hl_node *n) {
+  if (hl->stack_size == hl->stack_capacity) {
+    hl->stack_capacity = hl->stack_capacity ? 2 * hl->stack_capacity : 256;
+    hl->stack = realloc(hl->stack, hl->stack_capacity * sizeof(*hl->stack));
+  }
+  hl->stack[hl->stack_size++] = n;
+}
+
+__attribute__((const)) static inline uint64_t
+saturating_add(uint64_t a, uint64_t b) {
+  return a + b < a ? UINT64_MAX : a + b;
+}
+
+__attribute__((pure)) static inline size_t
+node_hash(struct hl_node *const child[hl_all_quadrants]) {
+  uint64_t h = 0;
+  for (size_t i = 0; i < hl_all_quadrants; ++i) {
+    h = (h ^ (uint64_t)(uintptr_t)child[i]) * UINT64_C(0x9E3779B97F4A7C15);
+    h ^= h >> 29;
+  }
+  return (size_t)h;
+}
+
+static void rehash(struct hashlife *hl, size_t num_buckets) {
+  struct hl_node **buckets = calloc(num_buckets, sizeof(*buckets));
+  for (size_t i = 0; i < hl->num_buckets; ++i) {
+    struct hl_node *n = hl->buckets[i];
+    while (n) {
+      struct hl_node *next = n->hash_next;
+      size_t h = node_hash(n->child) & (num_buckets - 1);
+      n->hash_next = buckets[h];
+      buckets[h] = n;
+      n = next;
+    }
+  }
+  free(hl->buckets);
+  hl->buckets = buckets;
+  hl->num_buckets = num_buckets;
+}
+
+static struct hl_node *allocate_node(struct hashlife *hl) {
+  if (hl->free_list) {
+    struct hl_node *n = hl->free_list;
+    hl->free_list = n->hash_next;
+    return n;
+  }
+  if (hl->num_chunks == 0 || hl->chunk_used == HASHLIFE_NODE_CHUNK) {
+    hl->chunks = realloc(hl->chunks, (hl->num_chunks + 1) * sizeof(*hl->chunks));
+    hl->chunks[hl->num_chunks++] =
+        malloc(HASHLIFE_NODE_CHUNK * sizeof(**hl->chunks));
+    hl->chunk_used = 0;
+  }
+  return &hl->chunks[hl->num_chunks - 1][hl->chunk_used++];
+}
+
+// Hash-consing: a given quadruple of children always yields the same node.
+static struct hl_node *find_node(struct hashlife *hl, struct hl_node *nw,
+                                 struct hl_node *ne, struct hl_node *sw,
+                                 struct hl_node *se) {
+  struct hl_node *child[hl_all_quadrants] = {nw, ne, sw, se};
+  size_t h = node_hash(child) & (hl->num_buckets - 1);
+  for (struct hl_node *n = hl->buckets[h]; n; n = n->hash_next)
+    if (memcmp(n->child, child, sizeof(child)) == 0)
+      return n;
+  struct hl_node *n = allocate_node(hl);
+  memcpy(n->child, child, sizeof(child));
+  n->result = NULL;
+  n->step_result = NULL;
+  n->level = nw->level + 1;
+  n->step = 0;
+  n->marked = false;
+  n->population = saturating_add(saturating_add(nw->population, ne->population),
+                                 saturating_add(sw->population, se->population));
+  n->hash_next = hl->buckets[h];
+  hl->buckets[h] = n;
+  if (++hl->num_nodes > hl->num_buckets)
+    rehash(hl, hl->num_buckets * 2);
+  return n;
+}
+
+static struct hl_node *empty_node(struct hashlife *hl, unsigned level) {
+  if (level == 0)
+    return &hl->leaves[0];
+  if (hl->empty[level] == NULL) {
+    struct hl_node *e = empty_node(hl, level - 1);
+    hl->empty[level] = find_node(hl, e, e, e, e);
+  }
+  return hl->empty[level];
+}
+
+static void init_hashlife(struct hashlife *hl, struct gol_rule rule) {
+  memset(hl, 0, sizeof(*hl));
+  hl->num_buckets = 1024;
+  hl->buckets = calloc(hl->num_buckets, sizeof(*hl->buckets));
+  hl->leaves[1].population = 1;
+  hl->rule = rule;
+  hl->max_nodes = HASHLIFE_MAX_NODES;
+}
+
+static void free_hashlife(struct hashlife *hl) {
+  for (size_t i = 0; i < hl->num_chunks; ++i)
+    free(hl->chunks[i]);
+  free(hl->chunks);
+  free(hl->buckets);
+  free(hl->stack);
+}
+
+static void mark_node(struct hl_node *n) {
+  if (n->level == 0 || n->marked)
+    return;
+  n->marked = true;
+  for (size_t i = 0; i < hl_all_quadrants; ++i)
+    mark_node(n->child[i]);
+}
+
+// Keeps the nodes reachable from the root and from the stack and forgets every
+// memoized result.
+static void collect_garbage(struct hashlife *hl, struct hl_node *root) {
+  if (root)
+    mark_node(root);
+  for (size_t i = 0; i < hl->stack_size; ++i)
+    mark_node(hl->stack[i]);
+  for (unsigned i = 1; i <= HASHLIFE_MAX_LEVEL; ++i)
+    if (hl->empty[i])
+      mark_node(hl->empty[i]);
+  memset(hl->buckets, 0, hl->num_buckets * sizeof(*hl->buckets));
+  hl->num_nodes = 0;
+  for (size_t c = 0; c < hl->num_chunks; ++c) {
+    size_t used = c + 1 == hl->num_chunks ? hl->chunk_used : HASHLIFE_NODE_CHUNK;
+    for (size_t i = 0; i < used; ++i) {
+      struct hl_node *n = &hl->chunks[c][i];
+      if (n->level == 0)
+        continue;
+      if (n->marked) {
+        size_t h = node_hash(n->child) & (hl->num_buckets - 1);
+        n->marked = false;
+        n->result = NULL;
+        n->step_result = NULL;
+        n->hash_next = hl->buckets[h];
+        hl->buckets[h] = n;
+        hl->num_nodes++;
+      } else {
+        n->level = 0;
+        n->hash_next = hl->free_list;
+        hl->free_list = n;
+      }
+    }
+  }
+  if (2 * hl->num_nodes > hl->max_nodes)
+    hl->max_nodes = 2 * hl->num_nodes;
+}
+
+// Level 2 node: 4x4 cells, returns the 2x2 center one generation later.
+static struct hl_node *advance_level2(struct hashlife *hl, struct hl_node *n) {
+  bool cells[4][4];
+  for (size_t y = 0; y < 4; ++y)
+    for (size_t x = 0; x < 4; ++x)
+      cells[y][x] = n->child[(y / 2) * 2 + x / 2]
+                        ->child[(y % 2) * 2 + x % 2]
+                        ->population != 0;
+  struct hl_node *center[hl_all_quadrants];
+  for (size_t y = 1; y < 3; ++y) {
+    for (size_t x = 1; x < 3; ++x) {
+      unsigned num_alive = 0;
+      for (size_t j = y - 1; j <= y + 1; ++j)
+        for (size_t i = x - 1; i <= x + 1; ++i)
+          num_alive += (j != y || i != x) && cells[j][i];
+      center[(y - 1) * 2 + x - 1] =
+          &hl->leaves[gol_next_state(hl->rule, cells[y][x], num_alive)];
+    }
+  }
+  return find_node(hl, center[hl_nw], center[hl_ne], center[hl_sw],
+                   center[hl_se]);
+}
+
+static struct hl_node *centered_node(struct hashlife *hl, struct hl_node *n) {
+  return find_node(hl, n->child[hl_nw]->child[hl_se],
+                   n->child[hl_ne]->child[hl_sw],
+                   n->child[hl_sw]->child[hl_ne],
+                   n->child[hl_se]->child[hl_nw]);
+}
+
+static struct hl_node *horizontal_node(struct hashlife *hl, struct hl_node *w,
+                                       struct hl_node *e) {
+  return find_node(hl, w->child[hl_ne], e->child[hl_nw], w->child[hl_se],
+                   e->child[hl_sw]);
+}
+
+static struct hl_node *vertical_node(struct hashlife *hl, struct hl_node *n,
+                                     struct hl_node *s) {
+  return find_node(hl, n->child[hl_sw], n->child[hl_se], s->child[hl_nw],
+                   s->child[hl_ne]);
+}
+
+// Returns the level-1 center of n advanced by 2^step generations, with
+// step <= level - 2.
+// The nodes computed here are pushed on the stack until the result is known,
+// a garbage collection may happen when entering the advance of a sub-node.
+static struct hl_node *advance(struct hashlife *hl, struct hl_node *n,
+                               unsigned step) {
+  if (n->population == 0)
+    return empty_node(hl, n->level - 1);
+  bool full_step = step == n->level - 2;
+  if (full_step && n->result)
+    return n->result;
+  if (!full_step && n->step_result && n->step == step)
+    return n->step_result;
+  size_t stack_size = hl->stack_size;
+  push_node(hl, n);
+  if (hl->num_nodes > hl->max_nodes)
+    collect_garbage(hl, NULL);
+
+  struct hl_node *result;
+  if (n->level == 2) {
+    result = advance_level2(hl, n);
+  } else {
+    struct hl_node *nw = n->child[hl_nw], *ne = n->child[hl_ne],
+                   *sw = n->child[hl_sw], *se = n->child[hl_se];
+    struct hl_node *sub[3][3] = {
+        {nw, horizontal_node(hl, nw, ne), ne},
+        {vertical_node(hl, nw, sw), centered_node(hl, n),
+         vertical_node(hl, ne, se)},
+        {sw, horizontal_node(hl, sw, se), se}};
+    for (size_t j = 0; j < 3; ++j)
+      for (size_t i = 0; i < 3; ++i)
+        push_node(hl, sub[j][i]);
+    struct hl_node *part[3][3];
+    // The full step goes twice through half steps, smaller steps only go
+    // through the second half.
+    for (size_t j = 0; j < 3; ++j) {
+      for (size_t i = 0; i < 3; ++i) {
+        part[j][i] = full_step ? advance(hl, sub[j][i], n->level - 3)
+                               : centered_node(hl, sub[j][i]);
+        push_node(hl, part[j][i]);
+      }
+    }
+    struct hl_node *quarter[hl_all_quadrants];
+    for (size_t j = 0; j < 2; ++j) {
+      for (size_t i = 0; i < 2; ++i) {
+        quarter[j * 2 + i] = advance(
+            hl,
+            find_node(hl, part[j][i], part[j][i + 1], part[j + 1][i],
+                      part[j + 1][i + 1]),
+            full_step ? n->level - 3 : step);
+        push_node(hl, quarter[j * 2 + i]);
+      }
+    }
+    result = find_node(hl, quarter[hl_nw], quarter[hl_ne], quarter[hl_sw],
+                       quarter[hl_se]);
+  }
+  if (full_step) {
+    n->result = result;
+  } else {
+    n->step_result = result;
+    n->step = step;
+  }
+  hl->stack_size = stack_size;
+  return result;
+}
+
+// Pads the node with an empty border, the old node becomes the center.
+static struct hl_node *expand_node(struct hashlife *hl, struct hl_node *n) {
+  struct hl_node *e = empty_node(hl, n->level - 1);
+  return find_node(hl, find_node(hl, e, e, e, n->child[hl_nw]),
+                   find_node(hl, e, e, n->child[hl_ne], e),
+                   find_node(hl, e, n->child[hl_sw], e, e),
+                   find_node(hl, n->child[hl_se], e, e, e));
+}
+
+// True when all the alive cells are in the center half of the node.
+__attribute__((pure)) static bool border_is_empty(const struct hl_node *n) {
+  static const enum hl_quadrant inner[hl_all_quadrants] = {hl_se, hl_sw, hl_ne,
+                                                           hl_nw};
+  for (size_t i = 0; i < hl_all_quadrants; ++i)
+    for (size_t j = 0; j < hl_all_quadrants; ++j)
+      if (j != inner[i] && n->child[i]->child[j]->population != 0)
+        return false;
+  return true;
+}
+
+static struct hl_node *build_node(struct hashlife *hl,
+                                  const struct gol_board *board, unsigned level,
+                                  intmax_t posX, intmax_t posY) {
+  if (level <= LOG2_BLOCKSIZE) {
+    intmax_t offsetX, offsetY;
+    get_offset(board, &offsetX, &offsetY);
+    intmax_t bx = block_coordinate_x(posX + offsetX);
+    intmax_t by = block_coordinate_y(posY + offsetY);
+    const struct basic_block *bb = get_gol_block(bx, by, board);
+    if (bb == NULL)
+      return empty_node(hl, level);
+    size_t inX = (size_t)(posX + offsetX - bx * BLOCKSIZE);
+    size_t inY = (size_t)(posY + offsetY - by * BLOCK_HEIGHT);
+    size_t side = (size_t)1 << level;
+    block_type mask = (block_type)(side == BLOCKSIZE
+                                       ? ~(block_type)0
+                                       : (((block_type)1 << side) - 1) << inX);
+    bool empty = true;
+    for (size_t j = inY; j < inY + side && empty; ++j)
+      empty = (gol_block_values(bb)[j] & mask) == 0;
+    if (empty)
+      return empty_node(hl, level);
+    if (level == 0)
+      return &hl->leaves[1];
+  }
+  intmax_t half = INTMAX_C(1) << (level - 1);
+  return find_node(hl, build_node(hl, board, level - 1, posX, posY),
+                   build_node(hl, board, level - 1, posX + half, posY),
+                   build_node(hl, board, level - 1, posX, posY + half),
+                   build_node(hl, board, level - 1, posX + half, posY + half));
+}
+
+// Distance from the first cell of the node to its first alive column along
+// the quadrants first and second, then third and fourth. Only the non empty
+// nodes on the searched side are visited.
+static intmax_t node_lower_edge(const struct hl_node *n, enum hl_quadrant first,
+                                enum hl_quadrant second, enum hl_quadrant third,
+                                enum hl_quadrant fourth) {
+  if (n->level == 0)
+    return 0;
+  intmax_t edge = INTMAX_MAX;
+  if (n->child[first]->population)
+    edge = node_lower_edge(n->child[first], first, second, third, fourth);
+  if (n->child[second]->population) {
+    intmax_t second_edge =
+        node_lower_edge(n->child[second], first, second, third, fourth);
+    edge = min(edge, second_edge);
+  }
+  if (edge != INTMAX_MAX)
+    return edge;
+  if (n->child[third]->population)
+    edge = node_lower_edge(n->child[third], first, second, third, fourth);
+  if (n->child[fourth]->population) {
+    intmax_t fourth_edge =
+        node_lower_edge(n->child[fourth], first, second, third, fourth);
+    edge = min(edge, fourth_edge);
+  }
+  return edge + (INTMAX_C(1) << (n->level - 1));
+}
+
+// Bounds of the alive cells of a non empty node.
+static struct gol_board_bounds node_bounds(const struct hl_node *n,
+                                           intmax_t posX, intmax_t posY) {
+  intmax_t last = (INTMAX_C(1) << n->level) - 1;
+  struct gol_board_bounds bounds = {
+      .lowerX = posX + node_lower_edge(n, hl_nw, hl_sw, hl_ne, hl_se),
+      .upperX = posX + last - node_lower_edge(n, hl_ne, hl_se, hl_nw, hl_sw),
+      .lowerY = posY + node_lower_edge(n, hl_nw, hl_ne, hl_sw, hl_se),
+      .upperY = posY + last - node_lower_edge(n, hl_sw, hl_se, hl_nw, hl_ne),
+  };
+  return bounds;
+}
+
+static void node_rows(const struct hl_node *n, size_t x, size_t y,
+                      block_type *rows) {
+  if (n->population == 0)
+    return;
+  if (n->level == 0) {
+    rows[y] |= (block_type)(uintdef(BLOCKSIZE, 1) << x);
+    return;
+  }
+  size_t half = (size_t)1 << (n->level - 1);
+  node_rows(n->child[hl_nw], x, y, rows);
+  node_rows(n->child[hl_ne], x + half, y, rows);
+  node_rows(n->child[hl_sw], x, y + half, rows);
+  node_rows(n->child[hl_se], x + half, y + half, rows);
+}
+
+// The nodes up to the block size are written row by row into their block.
+static void write_node(const struct hl_node *n, intmax_t posX, intmax_t posY,
+                       struct gol_board *board) {
+  if (n->population == 0)
+    return;
+  if (n->level <= LOG2_BLOCKSIZE) {
+    intmax_t offsetX, offsetY;
+    get_offset(board, &offsetX, &offsetY);
+    intmax_t bx = block_coordinate_x(posX + offsetX);
+    intmax_t by = block_coordinate_y(posY + offsetY);
+    size_t inX = (size_t)(posX + offsetX - bx * BLOCKSIZE);
+    size_t inY = (size_t)(posY + offsetY - by * BLOCK_HEIGHT);
+    block_type rows[BLOCK_HEIGHT] = {0};
+    node_rows(n, inX, 0, rows);
+    struct basic_block *bb = get_or_new_gol_block(bx, by, board);
+    for (size_t j = 0; j < ((size_t)1 << n->level); ++j)
+      bb->planes[bb->plane][inY + j] |= rows[j];
+    bb->unchanged = false;
+    return;
+  }
+  intmax_t half = INTMAX_C(1) << (n->level - 1);
+  write_node(n->child[hl_nw], posX, posY, board);
+  write_node(n->child[hl_ne], posX + half, posY, board);
+  write_node(n->child[hl_sw], posX, posY + half, board);
+  write_node(n->child[hl_se], posX + half, posY + half, board);
+}
+
+void hashlife_evolve_to_generation_n(size_t generation, struct gol_board *board,
+                                     bool verbose) {
+  if (generation == 0)
+    return;
+  struct hashlife hl;
+  init_hashlife(&hl, get_game_rules(board));
+
+  // The root origin is block aligned in the storage frame so that every node
+  // up to the block size lies inside a single block.
+  struct gol_board_bounds bounds = get_game_bounds(board);
+  intmax_t offsetX, offsetY;
+  get_offset(board, &offsetX, &offsetY);
+  intmax_t originX =
+      block_coordinate_x(bounds.lowerX + offsetX) * BLOCKSIZE - offsetX;
+  intmax_t originY =
+      block_coordinate_y(bounds.lowerY + offsetY) * BLOCK_HEIGHT - offsetY;
+  unsigned level = 3;
+  while ((INTMAX_C(1) << level) <= bounds.upperX - originX ||
+         (INTMAX_C(1) << level) <= bounds.upperY - originY)
+    level++;
+  struct hl_node *root = build_node(&hl, board, level, originX, originY);
+
+  for (unsigned step = 0; step < sizeof(generation) * 8 && generation >> step;
+       ++step) {
+    if (!((generation >> step) & 1))
+      continue;
+    if (verbose) {
+      printf("\rGeneration avancement %.0f%%",
+             100. * (double)(generation & ((((size_t)1) << step) - 1)) /
+                 (double)generation);
+      fflush(stdout);
+    }
+    // The alive cells must lie in the center quarter of the root so that
+    // their light cone stays inside the center half returned by advance.
+    bool centered = false;
+    while (!centered) {
+      centered = root->level >= step + 3 && border_is_empty(root) &&
+                 border_is_empty(centered_node(&hl, root));
+      if (centered)
+        break;
+      if (root->level == HASHLIFE_MAX_LEVEL) {
+        fprintf(stderr, "\nHashlife: the pattern outgrew the coordinates\n");
+        exit(EXIT_FAILURE);
+      }
+      intmax_t quarter = INTMAX_C(1) << (root->level - 1);
+      originX -= quarter;
+      originY -= quarter;
+      root = expand_node(&hl, root);
+    }
+    if (hl.num_nodes > hl.max_nodes)
+      collect_garbage(&hl, root);
+    intmax_t quarter = INTMAX_C(1) << (root->level - 2);
+    root = advance(&hl, root, step);
+    originX += quarter;
+    originY += quarter;
+  }
+  if (verbose)
+    printf("\rGeneration avancement 100%%\n");
+
+  clean_board(board);
+  if (root->population == 0) {
+    free_hashlife(&hl);
+    return;
+  }
+  // Re-center the board on the alive cells to spare memory, the root origin
+  // staying block aligned.
+  bounds = node_bounds(root, originX, originY);
+  intmax_t centerX = bounds.lowerX + (bounds.upperX - bounds.lowerX) / 2;
+  intmax_t centerY = bounds.lowerY + (bounds.upperY - bounds.lowerY) / 2;
+  intmax_t alignX = (originX - centerX) % BLOCKSIZE;
+  intmax_t alignY = (originY - centerY) % BLOCK_HEIGHT;
+  set_offset(-centerX - (alignX < 0 ? alignX + BLOCKSIZE : alignX),
+             -centerY - (alignY < 0 ? alignY + BLOCK_HEIGHT : alignY), board);
+  write_node(root, originX, originY, board);
+  set_game_bounds(&bounds, board);
+  free_hashlife(&hl);
+}
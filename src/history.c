@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "history.h"
+
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+
+struct snapshot_block {
+  size_t references;
+  block_type values[BLOCK_HEIGHT];
+};
+
+// Blocks held by all the snapshots
+static size_t num_snapshot_blocks = 0;
+
+struct snapshot_entry {
+  // Pattern coordinates of the first cell of the block
+  intmax_t x, y;
+  struct snapshot_block *block;
+};
+
+struct gol_snapshot {
+  size_t references;
+  intmax_t offsetX, offsetY;
+  struct gol_board_bounds bounds;
+  struct gol_rule rule;
+  struct snapshot_entry *entries;
+  size_t num_entries;
+};
+
+__attribute__((const)) static inline size_t entry_hash(intmax_t x,
+                                                       intmax_t y) {
+  uint64_t h = (uint64_t)x * UINT64_C(0x9e3779b97f4a7c15) ^
+               (uint64_t)y * UINT64_C(0xc2b2ae3d27d4eb4f);
+  return (size_t)(h ^ (h >> 29));
+}
+
+// Open addressing table of the entries of the previous snapshot, indices plus
+// one so that 0 is a free slot.
+static size_t *index_entries(const struct gol_snapshot *snapshot,
+                             size_t *size) {
+  *size = 64;
+  while (*size < 2 * snapshot->num_entries)
+    *size *= 2;
+  size_t *table = calloc(*size, sizeof(*table));
+  for (size_t n = 0; n < snapshot->num_entries; ++n) {
+    const struct snapshot_entry *entry = &snapshot->entries[n];
+    size_t i = entry_hash(entry->x, entry->y) & (*size - 1);
+    while (table[i] != 0)
+      i = (i + 1) & (*size - 1);
+    table[i] = n + 1;
+  }
+  return table;
+}
+
+static struct snapshot_block *
+find_entry_block(const struct gol_snapshot *snapshot, const size_t *table,
+                 size_t size, intmax_t x, intmax_t y) {
+  for (size_t i = entry_hash(x, y) & (size - 1); table[i] != 0;
+       i = (i + 1) & (size - 1)) {
+    const struct snapshot_entry *entry = &snapshot->entries[table[i] - 1];
+    if (entry->x == x && entry->y == y)
+      return entry->block;
+  }
+  return NULL;
+}
+
+struct gol_snapshot *take_gol_snapshot(const struct gol_board *board,
+                                       const struct gol_snapshot *previous) {
+  struct gol_snapshot *snapshot = malloc(sizeof(*snapshot));
+  snapshot->references = 1;
+  get_offset(board, &snapshot->offsetX, &snapshot->offsetY);
+  snapshot->rule = get_game_rules(board);
+  struct gol_block_position *positions;
+  snapshot->num_entries = list_gol_blocks(board, &positions);
+  snapshot->entries =
+      malloc(max(snapshot->num_entries, 1) * sizeof(*snapshot->entries));
+  struct gol_board_bounds *bounds = &snapshot->bounds;
+  *bounds = GOL_EMPTY_BOUNDS;
+  size_t table_size = 0;
+  size_t *table = previous ? index_entries(previous, &table_size) : NULL;
+  // The blocks evolved in place keep their storage position from one pass to
+  // the next, those flagged unchanged since the previous snapshot are shared
+  // without comparing them. The others, and all the blocks of the boards
+  // rebuilt every generation, are compared.
+  bool same_frame = previous && previous->offsetX == snapshot->offsetX &&
+                    previous->offsetY == snapshot->offsetY;
+  for (size_t n = 0; n < snapshot->num_entries; ++n) {
+    const struct basic_block *bb =
+        get_gol_block(positions[n].bx, positions[n].by, board);
+    struct snapshot_entry *entry = &snapshot->entries[n];
+    entry->x = positions[n].bx * BLOCKSIZE - snapshot->offsetX;
+    entry->y = positions[n].by * BLOCK_HEIGHT - snapshot->offsetY;
+    struct gol_board_bounds block_bounds;
+    gol_block_bounds(bb, entry->x, entry->y, &block_bounds);
+    bounds->lowerX = min(bounds->lowerX, block_bounds.lowerX);
+    bounds->upperX = max(bounds->upperX, block_bounds.upperX);
+    bounds->lowerY = min(bounds->lowerY, block_bounds.lowerY);
+    bounds->upperY = max(bounds->upperY, block_bounds.upperY);
+    struct snapshot_block *shared =
+        table ? find_entry_block(previous, table, table_size, entry->x,
+                                 entry->y)
+              : NULL;
+    if (shared && ((same_frame && bb->unchanged) ||
+                   memcmp(shared->values, gol_block_values(bb),
+                          sizeof(shared->values)) == 0)) {
+      shared->references++;
+      entry->block = shared;
+    } else {
+      entry->block = malloc(sizeof(*entry->block));
+      entry->block->references = 1;
+      memcpy(entry->block->values, gol_block_values(bb),
+             sizeof(entry->block->values));
+      num_snapshot_blocks++;
+    }
+  }
+  free(table);
+  free(positions);
+  return snapshot;
+}
+
+struct gol_snapshot *retain_gol_snapshot(struct gol_snapshot *snapshot) {
+  snapshot->references++;
+  return snapshot;
+}
+
+void release_gol_snapshot(struct gol_snapshot *snapshot) {
+  if (!snapshot || --snapshot->references != 0)
+    return;
+  for (size_t n = 0; n < snapshot->num_entries; ++n) {
+    struct snapshot_block *block = snapshot->entries[n].block;
+    if (--block->references == 0) {
+      free(block);
+      num_snapshot_blocks--;
+    }
+  }
+  free(snapshot->entries);
+  free(snapshot);
+}
+
+void restore_gol_snapshot(const struct gol_snapshot *snapshot,
+                          struct gol_board *board) {
+  clean_board(board);
+  set_offset(snapshot->offsetX, snapshot->offsetY, board);
+  set_game_rules(snapshot->rule, board);
+  for (size_t n = 0; n < snapshot->num_entries; ++n) {
+    const struct snapshot_entry *entry = &snapshot->entries[n];
+    struct basic_block *bb = get_or_new_gol_block(
+        block_coordinate_x(entry->x + snapshot->offsetX),
+        block_coordinate_y(entry->y + snapshot->offsetY), board);
+    memcpy(bb->planes[bb->plane], entry->block->values,
+           sizeof(entry->block->values));
+  }
+  if (snapshot->num_entries)
+    extend_game_bounds(&snapshot->bounds, board);
+}
+
+struct gol_history {
+  struct gol_snapshot **snapshots;
+  size_t *generations;
+  size_t capacity;
+  // Number of generations ever recorded, the newest is at
+  // (num_recorded - 1) % capacity.
+  size_t num_recorded;
+};
+
+struct gol_history *new_gol_history(size_t capacity) {
+  struct gol_history *history = malloc(sizeof(*history));
+  history->capacity = max(capacity, 1);
+  history->snapshots =
+      calloc(history->capacity, sizeof(*history->snapshots));
+  history->generations =
+      calloc(history->capacity, sizeof(*history->generations));
+  history->num_recorded = 0;
+  return history;
+}
+
+void free_gol_history(struct gol_history *history) {
+  if (!history)
+    return;
+  for (size_t i = 0; i < history->capacity; ++i)
+    release_gol_snapshot(history->snapshots[i]);
+  free(history->snapshots);
+  free(history->generations);
+  free(history);
+}
+
+void record_gol_generation(struct gol_history *history,
+                           const struct gol_board *board, size_t generation) {
+  const struct gol_snapshot *previous =
+      history->num_recorded
+          ? history->snapshots[(history->num_recorded - 1) % history->capacity]
+          : NULL;
+  struct gol_snapshot *snapshot = take_gol_snapshot(board, previous);
+  size_t slot = history->num_recorded % history->capacity;
+  release_gol_snapshot(history->snapshots[slot]);
+  history->snapshots[slot] = snapshot;
+  history->generations[slot] = generation;
+  history->num_recorded++;
+}
+
+const struct gol_snapshot *find_gol_snapshot(const struct gol_history *history,
+                                             size_t generation,
+                                             size_t *snapshot_generation) {
+  size_t retained = min(history->num_recorded, history->capacity);
+  if (retained == 0 ||
+      generation >
+          history->generations[(history->num_recorded - 1) % history->capacity])
+    return NULL;
+  for (size_t k = 1; k <= retained; ++k) {
+    size_t slot = (history->num_recorded - k) % history->capacity;
+    if (history->generations[slot] <= generation) {
+      *snapshot_generation = history->generations[slot];
+      return history->snapshots[slot];
+    }
+  }
+  return NULL;
+}
+
+void gol_history_size(const struct gol_history *history, size_t *num_snapshots,
+                      size_t *num_blocks) {
+  *num_snapshots = min(history->num_recorded, history->capacity);
+  *num_blocks = num_snapshot_blocks;
+}
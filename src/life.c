@@ -28,58 +28,98 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stdlib.h>
+#include <string.h>
+
+#include "block_kernel.h"
 #include "board.h"
+#include "cycle.h"
+#include "hashlife.h"
+#include "history.h"
 #include "life.h"
+#include "occupancy.h"
+#include "scheduler.h"
 
-__attribute__((const)) static inline bool is_alive_life(bool previous_state,
-                                                        size_t num_alive) {
-  switch (num_alive) {
-  case 3:
-    return true;
-  case 2:
-    return previous_state;
-  default:
-    return false;
-  }
-}
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#define min(a, b) (((a) < (b)) ? (a) : (b))
 
-__attribute__((const)) static inline bool is_alive_hilife(bool previous_state,
-                                                          size_t num_alive) {
-  switch (num_alive) {
-  case 3:
-  case 6:
-    return true;
-  case 2:
-    return previous_state;
-  default:
-    return false;
-  }
+char *gol_engine_string[unknownEngine] = {
+    [engineDense] = "dense",
+    [engineIterator] = "iterator",
+    [engineBlock] = "block",
+    [engineHashlife] = "hashlife",
+    [engineTemporal] = "temporal",
+};
+
+static size_t temporal_steps = GOL_DEFAULT_TEMPORAL_STEPS;
+
+// Generations between two compactions of the boards, which are also compacted
+// as soon as they shrink far below their peak.
+#define COMPACTION_PERIOD 1024
+
+void set_temporal_steps(size_t steps) {
+  temporal_steps = steps < 1 ? 1 : min(steps, GOL_MAX_TEMPORAL_STEPS);
 }
 
+size_t get_temporal_steps(void) { return temporal_steps; }
+
+static bool fixed_frame = false;
+
+void set_fixed_frame(bool fixed) { fixed_frame = fixed; }
+
+static struct gol_history *history = NULL;
+
+void set_gol_history(struct gol_history *h) { history = h; }
+
+// Only the cells of the active blocks, around the blocks holding alive cells,
+// and inside the bounds grown by one cell can be alive during the next
+// generation.
 static void get_next_generation(const struct gol_board *previous,
                                 struct gol_board *next,
-                                bool (*new_state)(bool, size_t)) {
+                                struct gol_rule rule) {
   struct gol_board_bounds previous_bounds = get_game_bounds(previous);
-  for (intmax_t i = previous_bounds.lowerX - 1; i <= previous_bounds.upperX + 1;
-       ++i) {
-    for (intmax_t j = previous_bounds.lowerY - 1;
-         j <= previous_bounds.upperY + 1; ++j) {
-      bool val = read_gol_board(i, j, previous);
-      size_t num_alive = val ? SIZE_MAX : 0;
-      for (intmax_t k = i - 1; k <= i + 1; ++k) {
-        for (intmax_t l = j - 1; l <= j + 1; ++l) {
-          num_alive += read_gol_board(k, l, previous) ? 1 : 0;
+  intmax_t offsetX, offsetY;
+  get_offset(previous, &offsetX, &offsetY);
+  struct gol_occupancy *occupancy = new_gol_occupancy(previous);
+  const struct gol_superblock *superblocks;
+  size_t num_superblocks = gol_occupancy_superblocks(occupancy, &superblocks);
+  for (size_t n = 0; n < num_superblocks; ++n) {
+    for (uint64_t active = superblocks[n].active; active;
+         active &= active - 1) {
+      size_t bit = (size_t)__builtin_ctzll(active);
+      intmax_t bx = superblocks[n].sx * GOL_SUPERBLOCK +
+                    (intmax_t)(bit % GOL_SUPERBLOCK),
+               by = superblocks[n].sy * GOL_SUPERBLOCK +
+                    (intmax_t)(bit / GOL_SUPERBLOCK);
+      intmax_t lowerX = max(bx * BLOCKSIZE - offsetX,
+                            previous_bounds.lowerX - 1),
+               upperX = min((bx + 1) * BLOCKSIZE - 1 - offsetX,
+                            previous_bounds.upperX + 1),
+               lowerY = max(by * BLOCK_HEIGHT - offsetY,
+                            previous_bounds.lowerY - 1),
+               upperY = min((by + 1) * BLOCK_HEIGHT - 1 - offsetY,
+                            previous_bounds.upperY + 1);
+      for (intmax_t i = lowerX; i <= upperX; ++i) {
+        for (intmax_t j = lowerY; j <= upperY; ++j) {
+          bool val = read_gol_board(i, j, previous);
+          size_t num_alive = val ? SIZE_MAX : 0;
+          for (intmax_t k = i - 1; k <= i + 1; ++k) {
+            for (intmax_t l = j - 1; l <= j + 1; ++l) {
+              num_alive += read_gol_board(k, l, previous) ? 1 : 0;
+            }
+          }
+          if (gol_next_state(rule, val, num_alive))
+            write_gol_board(i, j, true, next);
         }
       }
-      if (new_state(val, num_alive))
-        write_gol_board(i, j, true, next);
     }
   }
+  free_gol_occupancy(occupancy);
 }
 
 static void get_next_generation_iterator(struct gol_board *previous,
                                          struct gol_board *next,
-                                         bool (*new_state)(bool, size_t)) {
+                                         struct gol_rule rule) {
   struct gol_board_iterator *it = board_iterator_start(previous);
   while (!board_iterator_is_end(it)) {
     const struct gol_board_iterator_position pos = board_iterator_position(it);
@@ -93,7 +133,7 @@ static void get_next_generation_iterator(struct gol_board *previous,
               num_alive += read_gol_board(i, j, previous) ? 1 : 0;
             }
           }
-          if (new_state(val, num_alive))
+          if (gol_next_state(rule, val, num_alive))
             write_gol_board(k, l, true, next);
         }
       }
@@ -103,6 +143,145 @@ static void get_next_generation_iterator(struct gol_board *previous,
   board_iterator_free(it);
 }
 
+static const struct basic_block empty_block;
+
+struct generation_context {
+  struct gol_board *board;
+  struct gol_rule rule;
+  gol_block_kernel block_kernel;
+  gol_multistep_kernel multistep_kernel;
+  // Generations advanced by the pass
+  size_t steps;
+  // The unchanged flags of the blocks were set by a pass of as many
+  // generations
+  bool same_steps;
+  intmax_t offsetX, offsetY;
+  // Outcome of the pass for each block
+  enum block_outcome { blockSkipped, blockSame, blockChanged } *outcomes;
+  // One per thread
+  struct gol_board_bounds *bounds;
+  uint64_t *hashes;
+};
+
+// Computes the next generation of the blocks in their other plane, the
+// current planes of all the blocks stay untouched during the whole pass.
+static void evolve_block_tasks(size_t begin, size_t end, size_t thread,
+                               void *context) {
+  (void)thread;
+  struct generation_context *ctx = context;
+  for (size_t n = begin; n < end; ++n) {
+    intmax_t bx, by;
+    struct basic_block *center = gol_board_block(ctx->board, n, &bx, &by);
+    const struct basic_block *neighbourhood[3][3];
+    // Missing blocks are empty since at least the previous generation.
+    bool active = !ctx->same_steps || !center->unchanged;
+    for (size_t k = 0; k < 9; ++k) {
+      const struct basic_block *bb =
+          k == 4 ? center : center->neighbours[k - (k > 4)];
+      neighbourhood[k / 3][k % 3] = bb ? bb : &empty_block;
+      active = active || (bb && !bb->unchanged);
+    }
+    if (!active) {
+      ctx->outcomes[n] = blockSkipped;
+      continue;
+    }
+    block_type *next = center->planes[center->plane ^ 1];
+    if (ctx->steps == 1)
+      ctx->block_kernel(neighbourhood, next, ctx->rule);
+    else
+      ctx->multistep_kernel(neighbourhood, next, ctx->steps, ctx->rule);
+    ctx->outcomes[n] = memcmp(next, gol_block_values(center),
+                              sizeof(center->planes[0])) == 0
+                           ? blockSame
+                           : blockChanged;
+  }
+}
+
+// Makes the next generation current and gathers the bounds and hash of the
+// board.
+static void flip_block_tasks(size_t begin, size_t end, size_t thread,
+                             void *context) {
+  struct generation_context *ctx = context;
+  struct gol_board_bounds *bounds = &ctx->bounds[thread];
+  uint64_t *hash = &ctx->hashes[thread];
+  for (size_t n = begin; n < end; ++n) {
+    intmax_t bx, by;
+    struct basic_block *bb = gol_board_block(ctx->board, n, &bx, &by);
+    intmax_t originX = bx * BLOCKSIZE - ctx->offsetX,
+             originY = by * BLOCK_HEIGHT - ctx->offsetY;
+    bb->unchanged = ctx->outcomes[n] != blockChanged;
+    if (ctx->outcomes[n] == blockChanged)
+      bb->plane ^= 1;
+    if (ctx->outcomes[n] != blockSkipped)
+      bb->hash = gol_block_hash(bb, originX, originY);
+    struct gol_board_bounds block_bounds;
+    if (gol_block_bounds(bb, originX, originY, &block_bounds)) {
+      *hash += bb->hash;
+      bounds->lowerX = min(bounds->lowerX, block_bounds.lowerX);
+      bounds->upperX = max(bounds->upperX, block_bounds.upperX);
+      bounds->lowerY = min(bounds->lowerY, block_bounds.lowerY);
+      bounds->upperY = max(bounds->upperY, block_bounds.upperY);
+    }
+  }
+}
+
+// Every block carries its current and next generation: a pass evaluates all
+// the blocks of the board into their next plane, then flips the plane of those
+// that changed. Blocks keep their coordinates and their links from one
+// generation to the next, only the neighbours of the alive blocks that are
+// still missing get allocated. The blocks that stay empty are released by
+// compact_board.
+//
+// A block whose neighbourhood did not change during the last pass of as many
+// generations keeps its values. A pass advances `steps` generations. As a cell
+// cannot influence cells more than `steps` cells away, the same blocks are
+// evaluated whatever the number of steps up to GOL_MAX_TEMPORAL_STEPS.
+//
+// Returns the hash of the board.
+static uint64_t evolve_blocks(struct gol_board *board, size_t steps,
+                              bool same_steps, gol_block_kernel block_kernel,
+                              gol_multistep_kernel multistep_kernel) {
+  size_t num_alive_candidates = gol_board_num_blocks(board);
+  for (size_t n = 0; n < num_alive_candidates; ++n) {
+    intmax_t bx, by;
+    struct basic_block *bb = gol_board_block(board, n, &bx, &by);
+    if (gol_block_empty(bb))
+      continue;
+    for (enum gol_neighbour k = neighbourNW; k < allNeighbours; ++k)
+      if (bb->neighbours[k] == NULL)
+        get_or_new_gol_block(bx + (intmax_t)(k + (k > 3)) % 3 - 1,
+                             by + (intmax_t)(k + (k > 3)) / 3 - 1, board);
+  }
+  size_t num_blocks = gol_board_num_blocks(board);
+
+  struct generation_context context = {
+      .board = board,
+      .rule = get_game_rules(board),
+      .block_kernel = block_kernel,
+      .multistep_kernel = multistep_kernel,
+      .steps = steps,
+      .same_steps = same_steps,
+      .outcomes = malloc(max(num_blocks, 1) * sizeof(*context.outcomes)),
+      .bounds = malloc(gol_max_threads() * sizeof(*context.bounds)),
+      .hashes = calloc(gol_max_threads(), sizeof(*context.hashes))};
+  get_offset(board, &context.offsetX, &context.offsetY);
+  for (size_t t = 0; t < gol_max_threads(); ++t)
+    context.bounds[t] = GOL_EMPTY_BOUNDS;
+  gol_parallel_for(num_blocks, 64, evolve_block_tasks, &context);
+  gol_parallel_for(num_blocks, 64, flip_block_tasks, &context);
+  struct gol_board_bounds bounds = GOL_EMPTY_BOUNDS;
+  set_game_bounds(&bounds, board);
+  uint64_t hash = 0;
+  for (size_t t = 0; t < gol_max_threads(); ++t) {
+    extend_game_bounds(&context.bounds[t], board);
+    hash += context.hashes[t];
+  }
+  free(context.hashes);
+  free(context.bounds);
+  free(context.outcomes);
+  return hash;
+}
+
 static inline void center_offset(struct gol_board_bounds *bounds,
                                  struct gol_board *board) {
   intmax_t offsetX = -(bounds->upperX - bounds->lowerX) / 2;
@@ -112,16 +291,28 @@ static inline void center_offset(struct gol_board_bounds *bounds,
 
 void evolve_to_generation_n(size_t generation,
                             struct gol_board *const start_gen, bool verbose,
-                            bool iterator) {
+                            enum gol_engine engine) {
   if (generation == 0)
     return;
-  struct gol_board_bounds bounds;
-
-  struct gol_board *next_gen = new_board();
-  set_game_rules(get_game_rules(start_gen), next_gen);
+  if (history)
+    record_gol_generation(history, start_gen, 0);
+  if (engine == engineHashlife) {
+    hashlife_evolve_to_generation_n(generation, start_gen, verbose);
+    if (history)
+      record_gol_generation(history, start_gen, generation);
+    return;
+  }
+  // The block engines evolve their blocks in place, the other ones build
+  // each generation on a second board.
+  bool in_place = engine == engineBlock || engine == engineTemporal;
+  struct gol_board *next_gen = NULL;
+  if (!in_place) {
+    next_gen = new_board();
+    set_game_rules(get_game_rules(start_gen), next_gen);
+  }
   struct gol_board *current_gen = start_gen;
 
-  enum gol_rules rule = get_game_rules(start_gen);
+  struct gol_rule rule = get_game_rules(start_gen);
   float percentage;
   size_t verbose_step;
   if (generation >= 20) {
@@ -131,41 +322,86 @@ void evolve_to_generation_n(size_t generation,
     verbose_step = 1;
     percentage = 100. / (float)generation;
   }
-  bool (*life_count)(bool,size_t) = NULL;
-  switch (rule) {
-    case highLifeRule:
-      life_count = is_alive_hilife;
-      break;
-    case lifeRule:
-    default:
-      life_count = is_alive_life;
-      break;
-  }
+  gol_block_kernel block_kernel = get_block_kernel(rule);
+  gol_multistep_kernel multistep_kernel = get_multistep_kernel(rule);
+  size_t steps = 1, previous_steps = 1;
+  size_t next_compaction = COMPACTION_PERIOD;
+  struct gol_cycle_detector *cycles = new_cycle_detector();
   // Kernel
-  for (size_t i = 0; i < generation; ++i) {
-    if (verbose && i % verbose_step == 0) {
+  for (size_t i = 0; i < generation; i += steps) {
+    if (engine == engineTemporal)
+      steps = min(temporal_steps, generation - i);
+    if (verbose && i % verbose_step < steps) {
       printf("\rGeneration avancement %.0f%%", i / verbose_step * percentage);
       fflush(stdout);
     }
-    clean_board(next_gen);
-    bounds = get_game_bounds(current_gen);
-    // Re-center the to spare memory
-    center_offset(&bounds, next_gen);
-    if (iterator)
-      get_next_generation_iterator(current_gen, next_gen, life_count);
-    else
-      get_next_generation(current_gen, next_gen, life_count);
-    struct gol_board *swap_b = current_gen;
-    current_gen = next_gen;
-    next_gen = swap_b;
+    size_t skipped = 0;
+    if (in_place) {
+      uint64_t hash =
+          evolve_blocks(current_gen, steps, steps == previous_steps,
+                        block_kernel, multistep_kernel);
+      previous_steps = steps;
+      skipped = detect_cycle(cycles, current_gen, hash, i + steps, generation,
+                             verbose);
+    } else {
+      struct gol_board_bounds bounds = get_game_bounds(current_gen);
+      clean_board(next_gen);
+      if (fixed_frame) {
+        intmax_t offsetX, offsetY;
+        get_offset(current_gen, &offsetX, &offsetY);
+        set_offset(offsetX, offsetY, next_gen);
+      } else {
+        // Re-center the to spare memory
+        center_offset(&bounds, next_gen);
+      }
+      if (engine == engineIterator)
+        get_next_generation_iterator(current_gen, next_gen, rule);
+      else
+        get_next_generation(current_gen, next_gen, rule);
+      struct gol_board *swap_b = current_gen;
+      current_gen = next_gen;
+      next_gen = swap_b;
+    }
+    // The board of the previous generation is cleaned by the next pass
+    // anyway, cleaning it first lets its memory go too.
+    if (i + steps >= next_compaction || board_needs_compaction(current_gen)) {
+      compact_board(current_gen);
+      if (next_gen) {
+        clean_board(next_gen);
+        compact_board(next_gen);
+      }
+      next_compaction = i + steps + COMPACTION_PERIOD;
+    }
+    i += skipped;
+    if (history)
+      record_gol_generation(history, current_gen, i + steps);
   }
+  free_cycle_detector(cycles);
 
   if (verbose)
     printf("\rGeneration avancement 100%%\n");
   if (current_gen != start_gen) {
     gol_swap_board(next_gen, current_gen);
     free_board(current_gen);
-  } else {
+  } else if (next_gen) {
     free_board(next_gen);
   }
 }
+
+bool rewind_to_generation(size_t generation, struct gol_board *board,
+                          enum gol_engine engine) {
+  size_t snapshot_generation;
+  const struct gol_snapshot *snapshot =
+      history ? find_gol_snapshot(history, generation, &snapshot_generation)
+              : NULL;
+  if (snapshot == NULL)
+    return false;
+  restore_gol_snapshot(snapshot, board);
+  // The generations recomputed are already in the history
+  struct gol_history *recording = history;
+  history = NULL;
+  evolve_to_generation_n(generation - snapshot_generation, board, false,
+                         engine);
+  history = recording;
+  return true;
+}
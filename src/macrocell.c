@@ -0,0 +1,465 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macrocell.h"
+
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+
+// A node of level k is 2^k cells wide, the leaves are the 8x8 nodes.
+#define LEAF_LEVEL 3
+#define LEAF_SIZE 8
+// Deepest root whose corners fit in intmax_t
+#define MAX_LEVEL 62
+
+// Row i of a leaf is byte i of `leaf`, bit j of a row being column j. The
+// children of the other nodes are in the order nw, ne, sw, se.
+struct mc_node {
+  unsigned level;
+  uint64_t leaf;
+  size_t children[4];
+};
+
+// Hash-consed nodes, equal nodes have the same number. Node 0 is the empty
+// node of any level, nodes[0] is unused. Open addressing with linear probing
+// over the node numbers, 0 being a free slot. Never more than half full.
+struct mc_nodes {
+  struct mc_node *nodes;
+  size_t num_nodes, size_nodes;
+  size_t *table;
+  size_t size_table;
+};
+
+__attribute__((pure)) static inline size_t
+node_hash(const struct mc_node *node) {
+  uint64_t h = (uint64_t)node->level * UINT64_C(0x9e3779b97f4a7c15) ^
+               node->leaf * UINT64_C(0xc2b2ae3d27d4eb4f);
+  for (size_t i = 0; i < 4; ++i)
+    h = (h ^ node->children[i]) * UINT64_C(0xff51afd7ed558ccd);
+  return (size_t)(h ^ (h >> 29));
+}
+
+__attribute__((pure)) static inline bool same_node(const struct mc_node *n1,
+                                                   const struct mc_node *n2) {
+  return n1->level == n2->level && n1->leaf == n2->leaf &&
+         memcmp(n1->children, n2->children, sizeof(n1->children)) == 0;
+}
+
+// Slot of the node in the table, or the free slot where it would be.
+__attribute__((pure)) static inline size_t *
+node_slot(const struct mc_nodes *t, const struct mc_node *node) {
+  size_t mask = t->size_table - 1;
+  for (size_t i = node_hash(node) & mask;; i = (i + 1) & mask) {
+    size_t *slot = &t->table[i];
+    if (*slot == 0 || same_node(&t->nodes[*slot], node))
+      return slot;
+  }
+}
+
+static void resize_node_table(size_t new_size, struct mc_nodes *t) {
+  free(t->table);
+  t->table = calloc(new_size, sizeof(*t->table));
+  t->size_table = new_size;
+  for (size_t n = 1; n <= t->num_nodes; ++n)
+    *node_slot(t, &t->nodes[n]) = n;
+}
+
+// Number of the node, given to it the first time it is seen. The children
+// must be hash-consed first, so that every node comes after its children.
+static size_t hashcons_node(const struct mc_node *node, struct mc_nodes *t) {
+  bool empty = node->level == LEAF_LEVEL ? node->leaf == 0
+                                         : !(node->children[0] |
+                                             node->children[1] |
+                                             node->children[2] |
+                                             node->children[3]);
+  if (empty)
+    return 0;
+  if (2 * (t->num_nodes + 1) > t->size_table)
+    resize_node_table(max(2 * t->size_table, 1024), t);
+  size_t *slot = node_slot(t, node);
+  if (*slot == 0) {
+    if (t->num_nodes + 1 >= t->size_nodes) {
+      t->size_nodes = max(2 * t->size_nodes, 1024);
+      t->nodes = realloc(t->nodes, t->size_nodes * sizeof(*t->nodes));
+    }
+    *slot = ++t->num_nodes;
+    t->nodes[*slot] = *node;
+  }
+  return *slot;
+}
+
+static void free_nodes(struct mc_nodes *t) {
+  free(t->nodes);
+  free(t->table);
+}
+
+// Import
+
+// Rows of '.' (dead) and '*' (alive) ended by '$', the trailing dead cells and
+// empty rows being omitted.
+static bool parse_leaf(const char *line, uint64_t *leaf) {
+  size_t x = 0, y = 0;
+  *leaf = 0;
+  for (; *line != '\0' && *line != '\n' && *line != '\r'; ++line) {
+    switch (*line) {
+    case '.':
+      x++;
+      break;
+    case '*':
+      if (x >= LEAF_SIZE || y >= LEAF_SIZE)
+        return false;
+      *leaf |= UINT64_C(1) << (y * LEAF_SIZE + x);
+      x++;
+      break;
+    case '$':
+      y++;
+      x = 0;
+      break;
+    default:
+      return false;
+    }
+    if (x > LEAF_SIZE || y > LEAF_SIZE)
+      return false;
+  }
+  return true;
+}
+
+// Removes the end of line characters of the line.
+static char *strip_line(char *line) {
+  size_t size = strlen(line);
+  while (size && (line[size - 1] == '\n' || line[size - 1] == '\r'))
+    line[--size] = '\0';
+  return line;
+}
+
+// "#R rule", "#N name", "#O author" and "#C comment", the other lines (e.g.
+// "#G generation") are ignored.
+static bool parse_metadata(char *line, struct gol_game *game) {
+  char type = line[1];
+  char *value = line + 2;
+  while (*value == ' ' || *value == '\t')
+    value++;
+  struct gol_rule rule;
+  switch (type) {
+  case 'R':
+  case 'r':
+    if (!parse_gol_rule(strip_line(value), &rule))
+      return false;
+    set_game_rules(rule, game->board);
+    break;
+  case 'N':
+    set_pattern_name(strip_line(value), game);
+    break;
+  case 'O':
+    set_author(strip_line(value), game);
+    break;
+  case 'C':
+  case 'c':
+    add_comment(strip_line(value), game);
+    break;
+  }
+  return true;
+}
+
+// Node of the file: its number once hash-consed and its level.
+struct mc_file_node {
+  size_t id;
+  unsigned level;
+};
+
+// Returns the error, NULL if the line is a valid node.
+static const char *parse_node(const char *line,
+                              const struct mc_file_node *file_nodes,
+                              size_t num_file_nodes, struct mc_node *node) {
+  size_t children[4];
+  *node = (struct mc_node){.level = LEAF_LEVEL};
+  if (!isdigit((unsigned char)line[0]))
+    return parse_leaf(line, &node->leaf) ? NULL
+                                         : "expected a leaf made of '.', '*' "
+                                           "and '$' within 8x8 cells";
+  if (sscanf(line, "%u %zu %zu %zu %zu", &node->level, &children[0],
+             &children[1], &children[2], &children[3]) != 5)
+    return "expected a node: <level> <nw> <ne> <sw> <se>";
+  if (node->level <= LEAF_LEVEL || node->level > MAX_LEVEL)
+    return "node level out of range";
+  for (size_t i = 0; i < 4; ++i) {
+    if (children[i] > num_file_nodes)
+      return "node referencing a node not defined yet";
+    if (children[i] != 0 &&
+        file_nodes[children[i] - 1].level != node->level - 1)
+      return "child of a node not one level below it";
+    node->children[i] = children[i] ? file_nodes[children[i] - 1].id : 0;
+  }
+  return NULL;
+}
+
+struct mc_fill {
+  const struct mc_nodes *nodes;
+  struct gol_board *board;
+  struct gol_board_bounds bounds;
+};
+
+// The leaves are aligned on 8 cells as the blocks, a leaf is within a block.
+static void fill_leaf(uint64_t leaf, intmax_t x, intmax_t y,
+                      struct mc_fill *fill) {
+  intmax_t bx = block_coordinate_x(x), by = block_coordinate_y(y);
+  struct basic_block *bb = get_or_new_gol_block(bx, by, fill->board);
+  size_t shift = (size_t)(x - bx * intdef(MAX, BLOCKSIZE)),
+         in_bb_y = (size_t)(y - by * intdef(MAX, BLOCK_HEIGHT));
+  uint8_t columns = 0;
+  for (size_t i = 0; i < LEAF_SIZE; ++i) {
+    uint8_t row = (uint8_t)(leaf >> (LEAF_SIZE * i));
+    if (row == 0)
+      continue;
+    bb->planes[bb->plane][in_bb_y + i] |=
+        (block_type)((block_type)row << shift);
+    columns |= row;
+    fill->bounds.lowerY = min(fill->bounds.lowerY, y + (intmax_t)i);
+    fill->bounds.upperY = max(fill->bounds.upperY, y + (intmax_t)i);
+  }
+  bb->unchanged = false;
+  fill->bounds.lowerX =
+      min(fill->bounds.lowerX, x + __builtin_ctz(columns));
+  fill->bounds.upperX =
+      max(fill->bounds.upperX, x + 31 - __builtin_clz(columns));
+}
+
+// The node covers the cells from (x, y), the empty subtrees are skipped.
+static void fill_node(size_t id, intmax_t x, intmax_t y, struct mc_fill *fill) {
+  if (id == 0)
+    return;
+  const struct mc_node *node = &fill->nodes->nodes[id];
+  if (node->level == LEAF_LEVEL) {
+    fill_leaf(node->leaf, x, y, fill);
+    return;
+  }
+  intmax_t half = INTMAX_C(1) << (node->level - 1);
+  fill_node(node->children[0], x, y, fill);
+  fill_node(node->children[1], x + half, y, fill);
+  fill_node(node->children[2], x, y + half, fill);
+  fill_node(node->children[3], x + half, y + half, fill);
+}
+
+bool parse_macrocell_file(const char *mc_file, struct gol_game **b) {
+  *b = NULL;
+  FILE *file = fopen(mc_file, "r");
+  if (file == NULL) {
+    fprintf(stderr, "Error while parsing input macrocell file:\n%s: error: "
+                    "Unable to open file!\n",
+            mc_file);
+    return false;
+  }
+  struct gol_game *game = calloc(1, sizeof(*game));
+  game->board = new_board();
+  struct mc_nodes nodes = {0};
+  struct mc_file_node *file_nodes = NULL;
+  size_t num_file_nodes = 0, size_file_nodes = 0;
+  char *line = NULL;
+  size_t size_line = 0, line_number = 0;
+  const char *error = NULL;
+  while (error == NULL && getline(&line, &size_line, file) != -1) {
+    line_number++;
+    if (line_number == 1) {
+      if (strncmp(line, "[M2]", 4) != 0)
+        error = "expected the \"[M2]\" header of macrocell files";
+    } else if (line[0] == '#') {
+      if (!parse_metadata(line, game))
+        error = "expected a B/S rulestring without B0";
+    } else if (line[0] != '\n' && line[0] != '\r') {
+      struct mc_node node;
+      error = parse_node(line, file_nodes, num_file_nodes, &node);
+      if (error == NULL) {
+        if (num_file_nodes == size_file_nodes) {
+          size_file_nodes = max(2 * size_file_nodes, 1024);
+          file_nodes =
+              realloc(file_nodes, size_file_nodes * sizeof(*file_nodes));
+        }
+        file_nodes[num_file_nodes++] = (struct mc_file_node){
+            .id = hashcons_node(&node, &nodes), .level = node.level};
+      }
+    }
+  }
+  if (error == NULL && num_file_nodes == 0)
+    error = "expected at least one node";
+  if (error == NULL) {
+    // The root is the last node, centered on the origin
+    struct mc_file_node root = file_nodes[num_file_nodes - 1];
+    intmax_t corner = -(INTMAX_C(1) << (root.level - 1));
+    struct mc_fill fill = {
+        .nodes = &nodes, .board = game->board, .bounds = GOL_EMPTY_BOUNDS};
+    fill_node(root.id, corner, corner, &fill);
+    if (fill.bounds.lowerX <= fill.bounds.upperX)
+      extend_game_bounds(&fill.bounds, game->board);
+    *b = game;
+  } else {
+    fprintf(stderr,
+            "Error while parsing input macrocell file:\n%s:%zu: error: %s\n",
+            mc_file, line_number, error);
+    free_game(game);
+  }
+  free(line);
+  free(file_nodes);
+  free_nodes(&nodes);
+  fclose(file);
+  return error == NULL;
+}
+
+// Export
+
+// Node of a level of the tree and its position among the nodes of the level.
+struct mc_placed_node {
+  intmax_t x, y;
+  size_t id;
+};
+
+static int compare_parents(const void *n1, const void *n2) {
+  const struct mc_placed_node *p1 = n1, *p2 = n2;
+  intmax_t y1 = p1->y >> 1, y2 = p2->y >> 1, x1 = p1->x >> 1,
+           x2 = p2->x >> 1;
+  if (y1 != y2)
+    return y1 < y2 ? -1 : 1;
+  return x1 < x2 ? -1 : x1 > x2;
+}
+
+static void write_leaf(FILE *output_file, uint64_t leaf) {
+  char line[LEAF_SIZE * (LEAF_SIZE + 1) + 2];
+  size_t size = 0;
+  size_t num_rows = LEAF_SIZE - (size_t)__builtin_clzll(leaf) / LEAF_SIZE;
+  for (size_t i = 0; i < num_rows; ++i) {
+    uint8_t row = (uint8_t)(leaf >> (LEAF_SIZE * i));
+    for (size_t j = 0; row >> j; ++j)
+      line[size++] = (row >> j) & 1 ? '*' : '.';
+    line[size++] = '$';
+  }
+  line[size++] = '\n';
+  fwrite(line, 1, size, output_file);
+}
+
+// The blocks are cut into leaves, the tree is then built level by level by
+// grouping the nodes with the same parent. Identical leaves, hence identical
+// blocks and identical subtrees, are hash-consed into a single node.
+void dump_macrocell(FILE *output_file, struct gol_game *b) {
+  const struct gol_board *board = b->board;
+  struct gol_block_position *positions;
+  size_t num_blocks = list_gol_blocks(board, &positions);
+  const size_t leaves_per_block =
+      (BLOCKSIZE / LEAF_SIZE) * (BLOCK_HEIGHT / LEAF_SIZE);
+  struct mc_placed_node *placed =
+      malloc(max(num_blocks * leaves_per_block, 1) * sizeof(*placed));
+  size_t num_placed = 0;
+  struct mc_nodes nodes = {0};
+  struct gol_board_bounds bounds = GOL_EMPTY_BOUNDS;
+  for (size_t n = 0; n < num_blocks; ++n) {
+    const block_type *values = gol_block_values(
+        get_gol_block(positions[n].bx, positions[n].by, board));
+    for (size_t j = 0; j < BLOCK_HEIGHT / LEAF_SIZE; ++j) {
+      for (size_t i = 0; i < BLOCKSIZE / LEAF_SIZE; ++i) {
+        struct mc_node leaf = {.level = LEAF_LEVEL};
+        for (size_t r = 0; r < LEAF_SIZE; ++r)
+          leaf.leaf |= (uint64_t)(uint8_t)(values[j * LEAF_SIZE + r] >>
+                                           (i * LEAF_SIZE))
+                       << (r * LEAF_SIZE);
+        if (leaf.leaf == 0)
+          continue;
+        struct mc_placed_node node = {
+            .x = positions[n].bx * BLOCKSIZE + (intmax_t)(i * LEAF_SIZE),
+            .y = positions[n].by * BLOCK_HEIGHT + (intmax_t)(j * LEAF_SIZE),
+            .id = hashcons_node(&leaf, &nodes)};
+        bounds.lowerX = min(bounds.lowerX, node.x);
+        bounds.upperX = max(bounds.upperX, node.x + LEAF_SIZE - 1);
+        bounds.lowerY = min(bounds.lowerY, node.y);
+        bounds.upperY = max(bounds.upperY, node.y + LEAF_SIZE - 1);
+        placed[num_placed++] = node;
+      }
+    }
+  }
+  free(positions);
+
+  // Smallest root centered on the origin holding the leaves
+  unsigned root_level = LEAF_LEVEL + 1;
+  while (num_placed && root_level < MAX_LEVEL) {
+    intmax_t half = INTMAX_C(1) << (root_level - 1);
+    if (bounds.lowerX >= -half && bounds.lowerY >= -half &&
+        bounds.upperX < half && bounds.upperY < half)
+      break;
+    root_level++;
+  }
+  intmax_t half = INTMAX_C(1) << (root_level - 1);
+  for (size_t n = 0; n < num_placed; ++n) {
+    placed[n].x = (placed[n].x + half) / LEAF_SIZE;
+    placed[n].y = (placed[n].y + half) / LEAF_SIZE;
+  }
+  for (unsigned level = LEAF_LEVEL; level < root_level; ++level) {
+    qsort(placed, num_placed, sizeof(*placed), compare_parents);
+    size_t num_parents = 0;
+    for (size_t n = 0; n < num_placed;) {
+      struct mc_node parent = {.level = level + 1};
+      intmax_t x = placed[n].x >> 1, y = placed[n].y >> 1;
+      for (; n < num_placed && placed[n].x >> 1 == x && placed[n].y >> 1 == y;
+           ++n)
+        parent.children[(placed[n].y & 1) * 2 + (placed[n].x & 1)] =
+            placed[n].id;
+      placed[num_parents++] = (struct mc_placed_node){
+          .x = x, .y = y, .id = hashcons_node(&parent, &nodes)};
+    }
+    num_placed = num_parents;
+  }
+  free(placed);
+
+  fprintf(output_file, "[M2] (gol)\n");
+  char rule[GOL_RULE_STRING_SIZE];
+  format_gol_rule(get_game_rules(board), rule);
+  fprintf(output_file, "#R %s\n", rule);
+  if (b->authorName)
+    fprintf(output_file, "#O %s\n", b->authorName);
+  if (b->patternName)
+    fprintf(output_file, "#N %s\n", b->patternName);
+  for (size_t i = 0; i < b->num_comments; ++i)
+    fprintf(output_file, "#C %s\n", b->comments[i]);
+  // The nodes come after their children, the root being the last one
+  for (size_t n = 1; n <= nodes.num_nodes; ++n) {
+    const struct mc_node *node = &nodes.nodes[n];
+    if (node->level == LEAF_LEVEL)
+      write_leaf(output_file, node->leaf);
+    else
+      fprintf(output_file, "%u %zu %zu %zu %zu\n", node->level,
+              node->children[0], node->children[1], node->children[2],
+              node->children[3]);
+  }
+  if (nodes.num_nodes == 0)
+    fprintf(output_file, "%u 0 0 0 0\n", LEAF_LEVEL + 1);
+  free_nodes(&nodes);
+}
@@ -29,54 +29,102 @@
  */
 
 #include <getopt.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "block_kernel.h"
+#include "block_pool.h"
 #include "board.h"
+#include "geometry.h"
+#include "history.h"
 #include "life.h"
+#include "macrocell.h"
 #include "rle.h"
 #include "time_measurement.h"
 
-static struct option opt_options[] = {
-    {"help", no_argument, 0, 'h'},
-    {"verbose", no_argument, 0, 'v'},
-    {"output", required_argument, 0, 'o'},
-    {"compare-rle", required_argument, 0, 'c'},
-    {"generation", required_argument, 0, 'g'},
-    {"force-life", no_argument, 0, 'l'},
-    {"force-highlife", no_argument, 0, 'L'},
-    {"ascii-output", no_argument, 0, 'a'},
-    {"iterator", no_argument, 0, 'i'},
-    {0, 0, 0, 0}};
-
-static const char options[] = ":ho:c:g:lLavi";
-
 static const char help_string[] =
     "Options:"
-    "\n  -o --output          : Output file"
-    "\n  -c --compare-rle     : Compare the result to this file"
+    "\n  -o --output          : Output file, in the macrocell format if its"
+    "\n                         name ends with .mc"
+    "\n  -c --compare-rle     : Compare the result to this file (RLE or .mc)"
     "\n  -g --generation      : Select end generation (default 0)"
     "\n  -l --force-life      : Select Life rule"
     "\n  -L --force-highlife  : Select HighLife rule"
+    "\n  -r --rule            : Select any Life-like rule (e.g. B36/S23 or"
+    "\n                         23/36)"
     "\n  -a --ascii-output    : Output grid as ASCII"
-    "\n  -i --iterator        : Use grid sparse iterator"
+    "\n  -V --viewport        : Cells x0,y0,x1,y1 of the ASCII output"
+    "\n                         (default the whole pattern)"
+    "\n  -i --iterator        : Use grid sparse iterator (same as -e iterator)"
+    "\n  -e --engine          : Select the kernel: dense, iterator, block,"
+    "\n                         temporal or hashlife"
+    "\n                         (default block)"
+    "\n  -s --isa             : Instruction set of the block kernel, to debug"
+    "\n                         or compare them: scalar, sse2, avx2 or avx512"
+    "\n                         (default: best available). Those without a"
+    "\n                         measured gain for the geometry run the"
+    "\n                         scalar kernel"
+    "\n  -t --threads         : Number of threads of the block engine and of"
+    "\n                         the RLE loader (default 1, 0 for one per"
+    "\n                         core)"
+    "\n  -k --temporal-steps  : Generations per pass of the temporal engine"
+    "\n                         (default and at most half of the block"
+    "\n                         height, 1 for 64 cells wide blocks)"
+    "\n  -m --huge-pages      : Allocate the blocks on huge pages"
+    "\n  -x --index           : Block index of the boards: spiral, hash or"
+    "\n                         morton"
+    "\n                         (default spiral, hash for hashlife)"
+    "\n  -b --block           : Block geometry in cells: 8x8, 32x32, 64x64,"
+    "\n                         64x16 or auto to choose from the pattern"
+    "\n                         population, 32x32 for the temporal engine"
+    "\n                         (default auto)"
+    "\n  -H --history         : Keep snapshots of the board after the last n"
+    "\n                         passes, sharing their unchanged blocks"
+    "\n  -w --rewind          : Output this generation instead, recomputed"
+    "\n                         from the nearest snapshot kept by --history"
+    "\n  -f --fixed-frame     : Keep the cells of the dense and iterator"
+    "\n                         engines at the same place in memory instead"
+    "\n                         of centering the board every generation"
     "\n  -v --verbose         : Print solver avancement information"
     "\n  -h --help            : Print this help";
 
-int main(int argc, char **argv) {
+// Files ending with .mc are read as macrocell files, the others as RLE files.
+static bool parse_pattern_file(const char *file_name, struct gol_game **game) {
+  return gol_has_extension(file_name, ".mc")
+             ? parse_macrocell_file(file_name, game)
+             : parse_rle_file(file_name, game);
+}
+
+int run_gol(int argc, char **argv) {
   size_t goto_generation = 0;
   char *output_file_name = NULL;
   char *rle_to_compare = NULL;
-  bool force_life = false;
-  bool force_highlife = false;
+  bool force_rule = false;
+  struct gol_rule rule = gol_rule_definition[lifeRule];
   bool output_ascii = false;
+  struct gol_board_bounds viewport;
+  bool has_viewport = false;
   bool verbose = false;
-  bool use_iterator = false;
+  enum gol_engine engine = engineBlock;
+  enum gol_isa isa = detect_gol_isa();
+  // Chosen from the engine unless given
+  enum gol_board_index index = unknownIndex;
+  size_t num_threads = 1;
+  size_t steps = GOL_DEFAULT_TEMPORAL_STEPS;
+  size_t history_size = 0;
+  size_t rewind_generation = SIZE_MAX;
 
   while (true) {
     int sscanf_return;
-    int optchar = getopt_long(argc, argv, options, opt_options, NULL);
+    int optchar =
+        getopt_long(argc, argv, gol_short_options, gol_long_options, NULL);
     if (optchar == -1)
       break;
     switch (optchar) {
@@ -96,25 +144,131 @@ int main(int argc, char **argv) {
         goto_generation = 0;
       }
       break;
+    case 't':
+      sscanf_return = sscanf(optarg, "%zu", &num_threads);
+      if (sscanf_return == EOF || sscanf_return == 0) {
+        fprintf(stderr,
+                "Please input a positive thread number instead of \"-%c %s\"\n",
+                optchar, optarg);
+        exit(EXIT_FAILURE);
+      }
+      break;
+    case 'k':
+      sscanf_return = sscanf(optarg, "%zu", &steps);
+      if (sscanf_return == EOF || sscanf_return == 0 || steps == 0 ||
+          steps > GOL_MAX_TEMPORAL_STEPS) {
+        fprintf(stderr,
+                "Please input a number of steps between 1 and %d instead of "
+                "\"-%c %s\"\n",
+                GOL_MAX_TEMPORAL_STEPS, optchar, optarg);
+        exit(EXIT_FAILURE);
+      }
+      break;
+    case 'H':
+      sscanf_return = sscanf(optarg, "%zu", &history_size);
+      if (sscanf_return == EOF || sscanf_return == 0 || history_size == 0) {
+        fprintf(stderr,
+                "Please input a positive history size instead of \"-%c "
+                "%s\"\n",
+                optchar, optarg);
+        exit(EXIT_FAILURE);
+      }
+      break;
+    case 'w':
+      sscanf_return = sscanf(optarg, "%zu", &rewind_generation);
+      if (sscanf_return == EOF || sscanf_return == 0) {
+        fprintf(stderr,
+                "Please input a positive generation number instead of \"-%c "
+                "%s\"\n",
+                optchar, optarg);
+        exit(EXIT_FAILURE);
+      }
+      break;
     case 'l':
-      force_life = true;
-      force_highlife = false;
+      force_rule = true;
+      rule = gol_rule_definition[lifeRule];
       break;
     case 'L':
-      force_life = false;
-      force_highlife = true;
+      force_rule = true;
+      rule = gol_rule_definition[highLifeRule];
+      break;
+    case 'r':
+      force_rule = true;
+      if (!parse_gol_rule(optarg, &rule)) {
+        fprintf(stderr, "Invalid rule \"%s\"\n", optarg);
+        exit(EXIT_FAILURE);
+      }
       break;
     case 'a':
       output_ascii = true;
       break;
+    case 'V':
+      sscanf_return = sscanf(optarg, "%" SCNdMAX ",%" SCNdMAX ",%" SCNdMAX
+                                     ",%" SCNdMAX,
+                             &viewport.lowerX, &viewport.lowerY,
+                             &viewport.upperX, &viewport.upperY);
+      if (sscanf_return != 4 || viewport.lowerX > viewport.upperX ||
+          viewport.lowerY > viewport.upperY) {
+        fprintf(stderr,
+                "Please input the viewport as x0,y0,x1,y1 with x0 <= x1 and "
+                "y0 <= y1 instead of \"-%c %s\"\n",
+                optchar, optarg);
+        exit(EXIT_FAILURE);
+      }
+      has_viewport = true;
+      break;
     case 'v':
       verbose = true;
       break;
+    case 'm':
+      set_huge_pages(true);
+      break;
+    case 'f':
+      set_fixed_frame(true);
+      break;
     case 'i':
-      use_iterator = true;
+      engine = engineIterator;
+      break;
+    case 'e':
+      engine = unknownEngine;
+      for (enum gol_engine e = engineDense; e < unknownEngine; ++e)
+        if (strcmp(optarg, gol_engine_string[e]) == 0)
+          engine = e;
+      if (engine == unknownEngine) {
+        fprintf(stderr, "Unknown engine \"%s\"\n", optarg);
+        exit(EXIT_FAILURE);
+      }
+      break;
+    case 'x':
+      index = unknownIndex;
+      for (enum gol_board_index x = indexSpiral; x < unknownIndex; ++x)
+        if (strcmp(optarg, gol_board_index_string[x]) == 0)
+          index = x;
+      if (index == unknownIndex) {
+        fprintf(stderr, "Unknown block index \"%s\"\n", optarg);
+        exit(EXIT_FAILURE);
+      }
+      break;
+    case 'b':
+      // Already selected by main(), see geometry.c
+      break;
+    case 's':
+      isa = unknownIsa;
+      for (enum gol_isa s = isaScalar; s < unknownIsa; ++s)
+        if (strcmp(optarg, gol_isa_string[s]) == 0)
+          isa = s;
+      if (isa == unknownIsa) {
+        fprintf(stderr, "Unknown instruction set \"%s\"\n", optarg);
+        exit(EXIT_FAILURE);
+      }
+      if (!gol_isa_supported(isa)) {
+        fprintf(stderr, "Instruction set %s is not supported by this CPU\n",
+                optarg);
+        exit(EXIT_FAILURE);
+      }
       break;
     case 'h':
-      printf("Usage: %s <options> start_generation.rle\n%s\n", argv[0],
+      printf("Usage: %s <options> start_generation.(rle|mc)\n%s\n", argv[0],
              help_string);
       return EXIT_SUCCESS;
       break;
@@ -130,18 +284,34 @@ int main(int argc, char **argv) {
   }
 
   if (optind != argc - 1) {
-    fprintf(stderr, "Usage: %s <options> start_generation.rle\n%s\n", argv[0],
-            help_string);
+    fprintf(stderr, "Usage: %s <options> start_generation.(rle|mc)\n%s\n",
+            argv[0], help_string);
+    exit(EXIT_FAILURE);
+  }
+  if (rewind_generation != SIZE_MAX && history_size == 0) {
+    fprintf(stderr, "Rewinding needs a history, see --history\n");
     exit(EXIT_FAILURE);
   }
   char *input_file_name = argv[optind];
+  // The spiral index grows with the square of the extent of the pattern, the
+  // patterns advanced far by HashLife can spread over billions of cells.
+  if (index == unknownIndex)
+    index = engine == engineHashlife ? indexHash : indexSpiral;
+  set_board_index(index);
+#ifdef _OPENMP
+  if (num_threads != 0)
+    omp_set_num_threads((int)num_threads);
+#else
+  if (num_threads > 1)
+    fprintf(stderr, "Built without OpenMP support, running on one thread\n");
+#endif
   struct gol_game *game = NULL;
-  bool has_parsed = parse_rle_file(input_file_name, &game);
+  bool has_parsed = parse_pattern_file(input_file_name, &game);
   if (!has_parsed)
     exit(EXIT_FAILURE);
   struct gol_game *comparison_board = NULL;
   if (rle_to_compare) {
-    has_parsed = parse_rle_file(rle_to_compare, &comparison_board);
+    has_parsed = parse_pattern_file(rle_to_compare, &comparison_board);
     if (!has_parsed)
       exit(EXIT_FAILURE);
   }
@@ -160,20 +330,49 @@ int main(int argc, char **argv) {
   }
   if (output_ascii && !output_file)
     output_file = stdout;
-  if (force_life)
-    set_game_rules(lifeRule, game->board);
-  if (force_highlife)
-    set_game_rules(highLifeRule, game->board);
+  if (force_rule)
+    set_game_rules(rule, game->board);
+
+  select_gol_isa(isa);
+  set_temporal_steps(steps);
+  if (verbose)
+    printf("Block geometry: %s\n", GOL_GEOMETRY_STRING);
+  if (verbose && (engine == engineBlock || engine == engineTemporal))
+    printf("Block kernel instruction set: %s\n", gol_isa_string[isa]);
+  if (verbose && engine == engineTemporal)
+    printf("Generations per pass: %zu\n", get_temporal_steps());
+  struct gol_history *history = NULL;
+  if (history_size) {
+    history = new_gol_history(history_size);
+    set_gol_history(history);
+  }
 
   time_measure startTime, endTime;
   get_current_time(&startTime);
-  evolve_to_generation_n(goto_generation, game->board, verbose, use_iterator);
+  evolve_to_generation_n(goto_generation, game->board, verbose, engine);
   get_current_time(&endTime);
   fprintf(stdout, "Kernel time %.4fs\n",
           measuring_difftime(startTime, endTime));
+  if (verbose && history) {
+    size_t num_snapshots, num_blocks;
+    gol_history_size(history, &num_snapshots, &num_blocks);
+    printf("History: %zu snapshots holding %zu distinct blocks\n",
+           num_snapshots, num_blocks);
+  }
+  if (rewind_generation != SIZE_MAX) {
+    if (!rewind_to_generation(rewind_generation, game->board, engine)) {
+      fprintf(stderr, "Generation %zu is not covered by the history\n",
+              rewind_generation);
+      exit(EXIT_FAILURE);
+    }
+    if (verbose)
+      printf("Rewound to generation %zu\n", rewind_generation);
+  }
   if (output_file) {
     if (output_ascii)
-      dump_ASCII(output_file, game);
+      dump_ASCII(output_file, game, has_viewport ? &viewport : NULL);
+    else if (gol_has_extension(output_file_name, ".mc"))
+      dump_macrocell(output_file, game);
     else
       dump_rle(output_file, game);
   }
@@ -182,6 +381,7 @@ int main(int argc, char **argv) {
   if (rle_to_compare)
     same_board = gol_same_board(game->board, comparison_board->board);
 
+  free_gol_history(history);
   free_game(game);
   free_game(comparison_board);
   if (output_file)
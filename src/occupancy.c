@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+
+#include "occupancy.h"
+
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+
+// Columns x = 0 and x = GOL_SUPERBLOCK - 1 and rows y = 0 and
+// y = GOL_SUPERBLOCK - 1 of a mask
+#define WEST_COLUMN UINT64_C(0x0101010101010101)
+#define EAST_COLUMN UINT64_C(0x8080808080808080)
+#define NORTH_ROW UINT64_C(0x00000000000000ff)
+#define SOUTH_ROW UINT64_C(0xff00000000000000)
+// Moves row y = 0 of a mask to row y = GOL_SUPERBLOCK - 1
+#define LAST_ROW (GOL_SUPERBLOCK * (GOL_SUPERBLOCK - 1))
+
+// Open addressing with linear probing over the indexes of the superblocks,
+// SIZE_MAX being a free slot. Never more than half full.
+struct gol_occupancy {
+  struct gol_superblock *superblocks;
+  size_t num_superblocks, size_superblocks;
+  size_t *table;
+  size_t size_table;
+};
+
+__attribute__((const)) static inline intmax_t
+superblock_coordinate(intmax_t block) {
+  return block >= 0 ? block / GOL_SUPERBLOCK
+                    : -((-(block + 1)) / GOL_SUPERBLOCK) - 1;
+}
+
+__attribute__((const)) static inline size_t superblock_hash(intmax_t sx,
+                                                            intmax_t sy) {
+  uint64_t h = (uint64_t)sx * UINT64_C(0x9e3779b97f4a7c15) ^
+               (uint64_t)sy * UINT64_C(0xc2b2ae3d27d4eb4f);
+  return (size_t)(h ^ (h >> 29));
+}
+
+// Slot of the superblock in the table, or the free slot where it would be.
+__attribute__((pure)) static inline size_t *
+superblock_slot(const struct gol_occupancy *o, intmax_t sx, intmax_t sy) {
+  size_t mask = o->size_table - 1;
+  for (size_t i = superblock_hash(sx, sy) & mask;; i = (i + 1) & mask) {
+    size_t *slot = &o->table[i];
+    if (*slot == SIZE_MAX || (o->superblocks[*slot].sx == sx &&
+                              o->superblocks[*slot].sy == sy))
+      return slot;
+  }
+}
+
+static void resize_superblock_table(size_t new_size, struct gol_occupancy *o) {
+  free(o->table);
+  o->table = malloc(new_size * sizeof(*o->table));
+  o->size_table = new_size;
+  for (size_t i = 0; i < new_size; ++i)
+    o->table[i] = SIZE_MAX;
+  for (size_t n = 0; n < o->num_superblocks; ++n)
+    *superblock_slot(o, o->superblocks[n].sx, o->superblocks[n].sy) = n;
+}
+
+// The pointer is valid until the next superblock is added.
+static struct gol_superblock *find_or_new_superblock(intmax_t sx, intmax_t sy,
+                                                     struct gol_occupancy *o) {
+  if (2 * (o->num_superblocks + 1) > o->size_table)
+    resize_superblock_table(max(2 * o->size_table, 64), o);
+  size_t *slot = superblock_slot(o, sx, sy);
+  if (*slot == SIZE_MAX) {
+    if (o->num_superblocks == o->size_superblocks) {
+      o->size_superblocks = max(2 * o->size_superblocks, 64);
+      o->superblocks = realloc(o->superblocks, o->size_superblocks *
+                                                   sizeof(*o->superblocks));
+    }
+    *slot = o->num_superblocks++;
+    o->superblocks[*slot] =
+        (struct gol_superblock){.sx = sx, .sy = sy, .occupied = 0, .active = 0};
+  }
+  return &o->superblocks[*slot];
+}
+
+static inline void activate(intmax_t sx, intmax_t sy, uint64_t blocks,
+                            struct gol_occupancy *o) {
+  if (blocks)
+    find_or_new_superblock(sx, sy, o)->active |= blocks;
+}
+
+// The neighbours of the occupied blocks are found with shifts of the masks,
+// those across an edge of the superblock go to the neighbouring superblocks.
+static void spread_activity(struct gol_occupancy *o) {
+  size_t num_occupied = o->num_superblocks;
+  for (size_t n = 0; n < num_occupied; ++n) {
+    intmax_t sx = o->superblocks[n].sx, sy = o->superblocks[n].sy;
+    uint64_t occupied = o->superblocks[n].occupied;
+    uint64_t row = occupied | (occupied << 1 & ~WEST_COLUMN) |
+                   (occupied >> 1 & ~EAST_COLUMN);
+    o->superblocks[n].active |= row | row << GOL_SUPERBLOCK |
+                                row >> GOL_SUPERBLOCK;
+    uint64_t east = (occupied & EAST_COLUMN) >> (GOL_SUPERBLOCK - 1),
+             west = (occupied & WEST_COLUMN) << (GOL_SUPERBLOCK - 1);
+    activate(sx + 1, sy,
+             east | east << GOL_SUPERBLOCK | east >> GOL_SUPERBLOCK, o);
+    activate(sx - 1, sy,
+             west | west << GOL_SUPERBLOCK | west >> GOL_SUPERBLOCK, o);
+    activate(sx, sy - 1, (row & NORTH_ROW) << LAST_ROW, o);
+    activate(sx, sy + 1, (row & SOUTH_ROW) >> LAST_ROW, o);
+    activate(sx + 1, sy - 1, (east & NORTH_ROW) << LAST_ROW, o);
+    activate(sx - 1, sy - 1, (west & NORTH_ROW) << LAST_ROW, o);
+    activate(sx + 1, sy + 1, (east & SOUTH_ROW) >> LAST_ROW, o);
+    activate(sx - 1, sy + 1, (west & SOUTH_ROW) >> LAST_ROW, o);
+  }
+}
+
+struct gol_occupancy *new_gol_occupancy(const struct gol_board *board) {
+  struct gol_occupancy *o = calloc(1, sizeof(*o));
+  size_t num_blocks = gol_board_num_blocks(board);
+  for (size_t n = 0; n < num_blocks; ++n) {
+    intmax_t bx, by;
+    const struct basic_block *bb = gol_board_block(board, n, &bx, &by);
+    if (!gol_block_empty(bb))
+      find_or_new_superblock(superblock_coordinate(bx),
+                             superblock_coordinate(by), o)
+          ->occupied |= UINT64_C(1) << gol_superblock_bit(bx, by);
+  }
+  spread_activity(o);
+  return o;
+}
+
+void free_gol_occupancy(struct gol_occupancy *o) {
+  free(o->superblocks);
+  free(o->table);
+  free(o);
+}
+
+size_t gol_occupancy_superblocks(const struct gol_occupancy *o,
+                                 const struct gol_superblock **superblocks) {
+  *superblocks = o->superblocks;
+  return o->num_superblocks;
+}
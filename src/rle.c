@@ -28,25 +28,43 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <ctype.h>
+#include <fcntl.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "board.h"
 #include "mpc.h"
 #include "rle.h"
+#include "scheduler.h"
 
-static mpc_val_t *returnLife(mpc_val_t *val) {
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+
+struct parsedRule {
+  bool valid;
+  struct gol_rule rule;
+};
+
+static mpc_val_t *toRule(mpc_val_t *val) {
+  struct parsedRule *rule = malloc(sizeof(*rule));
+  rule->valid = parse_gol_rule(val, &rule->rule);
   free(val);
-  enum gol_rules *rule = malloc(sizeof(*rule));
-  *rule = lifeRule;
   return rule;
 }
 
-static mpc_val_t *returnHighLife(mpc_val_t *val) {
-  free(val);
-  enum gol_rules *rule = malloc(sizeof(*rule));
-  *rule = highLifeRule;
-  return rule;
+static int isValidRule(mpc_val_t **val) {
+  struct parsedRule *rule = *val;
+  if (rule->valid)
+    return 1;
+  free(rule);
+  *val = NULL;
+  return 0;
 }
 
 static mpc_val_t *toIntMax(mpc_val_t *val) {
@@ -72,7 +90,7 @@ struct preHeader {
       intmax_t offsetX;
       intmax_t offsetY;
     };
-    enum gol_rules rule;
+    struct gol_rule rule;
   };
 };
 
@@ -108,8 +126,8 @@ static mpc_val_t *phCreatorName(mpc_val_t *val) {
 static mpc_val_t *phGameRules(mpc_val_t *val) {
   struct preHeader *ph = malloc(sizeof(*ph));
   ph->type = preHeaderGameRules;
-  enum gol_rules *rule = (enum gol_rules *)val;
-  ph->rule = *rule;
+  struct parsedRule *rule = (struct parsedRule *)val;
+  ph->rule = rule->rule;
   free(rule);
   return ph;
 }
@@ -130,18 +148,18 @@ static mpc_val_t *phCoordinateOffset(int n, mpc_val_t **val) {
 struct headerLine {
   intmax_t sizeX;
   intmax_t sizeY;
-  enum gol_rules ruleSet;
+  bool hasRuleSet;
+  struct parsedRule ruleSet;
 };
 
 static mpc_val_t *headerFold(int n, mpc_val_t **val) {
   struct headerLine *hl = malloc(sizeof(*hl));
   intmax_t **vv = (intmax_t **)val;
-  enum gol_rules *rl = (enum gol_rules *)val[7];
+  struct parsedRule *rl = (struct parsedRule *)val[7];
+  hl->hasRuleSet = rl != NULL;
   if (rl != NULL) {
     hl->ruleSet = *rl;
     free(rl);
-  } else {
-    hl->ruleSet = unknownRule;
   }
   hl->sizeX = *vv[2];
   hl->sizeY = *vv[6];
@@ -152,6 +170,15 @@ static mpc_val_t *headerFold(int n, mpc_val_t **val) {
   return hl;
 }
 
+static int headerHasValidRule(mpc_val_t **val) {
+  struct headerLine *hl = *val;
+  if (!hl->hasRuleSet || hl->ruleSet.valid)
+    return 1;
+  free(hl);
+  *val = NULL;
+  return 0;
+}
+
 enum itemType {
   itemDead,
   itemAlive,
@@ -239,8 +266,8 @@ static mpc_val_t *foldRleFile(int n, mpc_val_t **val) {
   /*fprintf(stderr, "Header x = %" PRIdMAX ", y = %" PRIdMAX ", ruleset =
    * %d\n",*/
   /*hl->sizeX, hl->sizeY, hl->ruleSet);*/
-  if (hl->ruleSet != unknownRule)
-    set_game_rules(hl->ruleSet, game->board);
+  if (hl->hasRuleSet)
+    set_game_rules(hl->ruleSet.rule, game->board);
   struct Item *tmpItem = items[0];
   intmax_t posX = 0, posY = 0;
   for (size_t num = 0; tmpItem != NULL; tmpItem = items[++num]) {
@@ -293,13 +320,13 @@ static void freeAllItems(void **all) {
   free(all);
 }
 
-bool parse_rle_file(const char *rle_file, struct gol_game **b) {
+// Slow but detailed, used to report the errors of the files the streaming
+// parser rejects.
+static bool parse_rle_file_mpc(const char *rle_file, struct gol_game **b) {
 
   *b = calloc(1, sizeof(**b));
   (*b)->board = new_board();
 
-  mpc_parser_t *Life = mpc_new("life");
-  mpc_parser_t *HighLife = mpc_new("highLife");
   mpc_parser_t *Number = mpc_new("number");
   mpc_parser_t *PositiveNumber = mpc_new("positiveNumber");
   mpc_parser_t *StringLine = mpc_new("stringLine");
@@ -325,7 +352,7 @@ bool parse_rle_file(const char *rle_file, struct gol_game **b) {
 
   mpc_define(
       HeaderLine,
-      mpc_predictive(mpc_and(
+      mpc_check(mpc_predictive(mpc_and(
           8, headerFold, mpc_stripl(mpc_char('x')), mpc_stripl(mpc_char('=')),
           mpc_stripl(PositiveNumber), mpc_stripl(mpc_char(',')),
           mpc_stripl(mpc_char('y')), mpc_stripl(mpc_char('=')),
@@ -335,18 +362,10 @@ bool parse_rle_file(const char *rle_file, struct gol_game **b) {
                                     mpc_stripl(mpc_string("rule")),
                                     mpc_stripl(mpc_char('=')), free, free),
                             mpc_stripl(RuleSet), mpcf_dtor_null)),
-          free, free, free, free, free, free, free)));
-
-  mpc_define(Life, mpc_apply(mpc_or(3, mpc_string("B3/S23"),
-                                    mpc_string("b3/s23"), mpc_string("23/3")),
-                             returnLife));
-
-  mpc_define(HighLife,
-             mpc_apply(mpc_or(3, mpc_string("B36/S23"), mpc_string("b36/s23"),
-                              mpc_string("23/36")),
-                       returnHighLife));
+          free, free, free, free, free, free, free)),
+      headerHasValidRule, "a B/S rulestring without B0"));
 
-  mpc_define(RuleSet, mpc_or(2, Life, HighLife));
+  mpc_define(RuleSet, mpc_apply(mpc_re("[bBsS0-8/]+"), toRule));
 
   mpc_define(Number,
              mpc_expect(mpc_apply(mpc_re("-?[0-9]+"), toIntMax), "an integer"));
@@ -380,7 +399,12 @@ bool parse_rle_file(const char *rle_file, struct gol_game **b) {
 
   mpc_define(GameRules,
              mpc_and(2, mpcf_snd_free, mpc_char('r'),
-                     mpc_apply(mpc_stripl(StringLine), phGameRules), free));
+                     mpc_apply(mpc_check(mpc_apply(mpc_stripl(StringLine),
+                                                   toRule),
+                                         isValidRule,
+                                         "a B/S rulestring without B0"),
+                               phGameRules),
+                     free));
 
   mpc_define(CoordinateOffset,
              mpc_and(3, phCoordinateOffset,
@@ -399,8 +423,6 @@ bool parse_rle_file(const char *rle_file, struct gol_game **b) {
   mpc_optimise(Number);
   mpc_optimise(PositiveNumber);
   mpc_optimise(StringLine);
-  mpc_optimise(Life);
-  mpc_optimise(HighLife);
   mpc_optimise(RuleSet);
   mpc_optimise(Comment);
   mpc_optimise(PatternName);
@@ -422,32 +444,459 @@ bool parse_rle_file(const char *rle_file, struct gol_game **b) {
     free_game(*b);
   }
 
-  mpc_cleanup(16, Number, StringLine, Life, HighLife, RuleSet, Comment,
+  mpc_cleanup(14, Number, StringLine, RuleSet, Comment,
               PatternName, CreatorName, GameRules, CoordinateOffset, PreHeader,
               HeaderLine, Item, CellGrid, RleFile, PositiveNumber);
   return parse_success;
 }
 
-static void print_cell_state(FILE *output_file, bool previous_was_alive,
-                             size_t previous_cells_in_state,
-                             int *num_written_in_line) {
-  if (previous_cells_in_state) {
-    char p = previous_was_alive ? 'o' : 'b';
-    int num_to_write;
-    if (previous_cells_in_state > 1) {
-      num_to_write = snprintf(NULL, 0, "%zu%c", previous_cells_in_state, p);
+// Streaming parser: a single pass over the mapped file, the runs of alive
+// cells are written straight into the block rows. It accepts a subset of the
+// mpc grammar and gives up on anything else.
+
+struct rle_input {
+  const char *pos, *end;
+};
+
+static inline void skip_whitespaces(struct rle_input *in) {
+  while (in->pos < in->end && isspace((unsigned char)*in->pos))
+    in->pos++;
+}
+
+static inline void skip_blanks(struct rle_input *in) {
+  while (in->pos < in->end && (*in->pos == ' ' || *in->pos == '\t'))
+    in->pos++;
+}
+
+static inline bool expect_char(char c, struct rle_input *in) {
+  skip_whitespaces(in);
+  if (in->pos == in->end || *in->pos != c)
+    return false;
+  in->pos++;
+  return true;
+}
+
+// Numbers without leading zero, the sign is only accepted if is_signed.
+static bool read_number(bool is_signed, struct rle_input *in,
+                        intmax_t *value) {
+  bool negative = is_signed && in->pos < in->end && *in->pos == '-';
+  if (negative)
+    in->pos++;
+  if (in->pos == in->end || !isdigit((unsigned char)*in->pos) ||
+      (!is_signed && *in->pos == '0'))
+    return false;
+  *value = 0;
+  for (; in->pos < in->end && isdigit((unsigned char)*in->pos); in->pos++) {
+    if (*value > (INTMAX_MAX - 9) / 10)
+      return false;
+    *value = *value * 10 + (*in->pos - '0');
+  }
+  if (negative)
+    *value = -*value;
+  return true;
+}
+
+// Rest of the line, without its leading blanks.
+static char *read_line(struct rle_input *in) {
+  skip_blanks(in);
+  const char *line_end = memchr(in->pos, '\n', (size_t)(in->end - in->pos));
+  if (line_end == NULL)
+    line_end = in->end;
+  size_t size = (size_t)(line_end - in->pos);
+  char *line = malloc(size + 1);
+  memcpy(line, in->pos, size);
+  line[size] = '\0';
+  in->pos = line_end;
+  return line;
+}
+
+static bool read_rule(struct rle_input *in, struct gol_rule *rule) {
+  char *rulestring = read_line(in);
+  bool valid = parse_gol_rule(rulestring, rule);
+  free(rulestring);
+  return valid;
+}
+
+static bool stream_preheader(struct rle_input *in, struct gol_game *game) {
+  while (expect_char('#', in)) {
+    if (in->pos == in->end)
+      return false;
+    char *line;
+    intmax_t offsetX, offsetY;
+    struct gol_rule rule;
+    switch (*in->pos++) {
+    case 'C':
+    case 'c':
+      line = read_line(in);
+      add_comment(line, game);
+      free(line);
+      break;
+    case 'N':
+      line = read_line(in);
+      set_pattern_name(line, game);
+      free(line);
+      break;
+    case 'O':
+      line = read_line(in);
+      set_author(line, game);
+      free(line);
+      break;
+    case 'r':
+      if (!read_rule(in, &rule))
+        return false;
+      set_game_rules(rule, game->board);
+      break;
+    case 'P':
+    case 'R':
+      skip_whitespaces(in);
+      if (!read_number(true, in, &offsetX))
+        return false;
+      skip_whitespaces(in);
+      if (!read_number(true, in, &offsetY))
+        return false;
+      set_offset(offsetX, offsetY, game->board);
+      break;
+    default:
+      return false;
+    }
+  }
+  return true;
+}
+
+// Characters of [bBsS0-8/]
+__attribute__((const)) static inline bool is_rule_char(char c) {
+  return (c >= '0' && c <= '8') || c == 'b' || c == 'B' || c == 's' ||
+         c == 'S' || c == '/';
+}
+
+static bool stream_header(struct rle_input *in, struct gol_game *game) {
+  intmax_t size;
+  if (!expect_char('x', in) || !expect_char('=', in))
+    return false;
+  skip_whitespaces(in);
+  if (!read_number(false, in, &size) || !expect_char(',', in) ||
+      !expect_char('y', in) || !expect_char('=', in))
+    return false;
+  skip_whitespaces(in);
+  if (!read_number(false, in, &size))
+    return false;
+  const char *after_size = in->pos;
+  if (!expect_char(',', in)) {
+    in->pos = after_size;
+    return true;
+  }
+  skip_whitespaces(in);
+  if ((size_t)(in->end - in->pos) < 4 || memcmp(in->pos, "rule", 4) != 0)
+    return false;
+  in->pos += 4;
+  if (!expect_char('=', in))
+    return false;
+  skip_whitespaces(in);
+  const char *rule_end = in->pos;
+  while (rule_end < in->end && is_rule_char(*rule_end))
+    rule_end++;
+  char rulestring[GOL_RULE_STRING_SIZE + 1];
+  size_t rule_size = (size_t)(rule_end - in->pos);
+  if (rule_size == 0 || rule_size > GOL_RULE_STRING_SIZE)
+    return false;
+  memcpy(rulestring, in->pos, rule_size);
+  rulestring[rule_size] = '\0';
+  in->pos = rule_end;
+  struct gol_rule rule;
+  if (!parse_gol_rule(rulestring, &rule))
+    return false;
+  set_game_rules(rule, game->board);
+  return true;
+}
+
+// Decodes the items of [in->pos, in->end) up to the end of the pattern '!',
+// starting at (*posX, *posY). Without board, the items are only counted.
+static bool decode_cells(struct rle_input *in, intmax_t *posX, intmax_t *posY,
+                         struct gol_board *board) {
+  while (true) {
+    skip_whitespaces(in);
+    if (in->pos == in->end || *in->pos == '!')
+      return true;
+    intmax_t num = 1;
+    if (isdigit((unsigned char)*in->pos) && !read_number(false, in, &num))
+      return false;
+    if (in->pos == in->end)
+      return false;
+    char item = *in->pos++;
+    if (item == '$') {
+      *posY += num;
+      *posX = 0;
+    } else if (item == 'b') {
+      *posX += num;
+    } else if (isalpha((unsigned char)item)) {
+      if (board)
+        write_gol_board_run(*posX, *posY, num, board);
+      *posX += num;
     } else {
-      num_to_write = 1;
+      return false;
     }
-    if (*num_written_in_line + num_to_write > 69) {
-      fprintf(output_file, "\n");
-      *num_written_in_line = 0;
+  }
+}
+
+// Cell grids smaller than this are decoded on one thread.
+#define PARALLEL_RLE_CHUNK (UINTMAX_C(1) << 22)
+
+// A chunk of the cell grid moves the position by endY rows, ending at column
+// endX of its last row if it has line jumps, endX columns further otherwise.
+struct rle_chunk {
+  struct rle_input in;
+  intmax_t startX, startY, endX, endY;
+  struct gol_board *board;
+  bool valid;
+};
+
+struct rle_chunks_context {
+  struct rle_chunk *chunks;
+  const struct gol_board *board;
+};
+
+static void count_chunks_task(size_t begin, size_t end, size_t thread,
+                              void *context) {
+  (void)thread;
+  struct rle_chunks_context *ctx = context;
+  for (size_t i = begin; i < end; ++i) {
+    struct rle_chunk *chunk = &ctx->chunks[i];
+    struct rle_input in = chunk->in;
+    chunk->endX = chunk->endY = 0;
+    chunk->valid = decode_cells(&in, &chunk->endX, &chunk->endY, NULL);
+  }
+}
+
+// Each chunk writes into a board of its own, with the offset of the pattern.
+static void decode_chunks_task(size_t begin, size_t end, size_t thread,
+                               void *context) {
+  (void)thread;
+  struct rle_chunks_context *ctx = context;
+  intmax_t offsetX, offsetY;
+  get_offset(ctx->board, &offsetX, &offsetY);
+  for (size_t i = begin; i < end; ++i) {
+    struct rle_chunk *chunk = &ctx->chunks[i];
+    struct rle_input in = chunk->in;
+    chunk->board = new_board();
+    set_offset(offsetX, offsetY, chunk->board);
+    intmax_t posX = chunk->startX, posY = chunk->startY;
+    decode_cells(&in, &posX, &posY, chunk->board);
+  }
+}
+
+static void merge_chunk_board(const struct gol_board *chunk_board,
+                              struct gol_board *board) {
+  size_t num_blocks = gol_board_num_blocks(chunk_board);
+  if (num_blocks == 0)
+    return;
+  for (size_t n = 0; n < num_blocks; ++n) {
+    intmax_t bx, by;
+    const struct basic_block *from = gol_board_block(chunk_board, n, &bx, &by);
+    struct basic_block *to = get_or_new_gol_block(bx, by, board);
+    for (size_t y = 0; y < BLOCK_HEIGHT; ++y)
+      to->planes[to->plane][y] |= gol_block_values(from)[y];
+    to->unchanged = false;
+  }
+  struct gol_board_bounds bounds = get_game_bounds(chunk_board);
+  extend_game_bounds(&bounds, board);
+}
+
+// The grid is cut into chunks between two items. The start of each chunk is
+// the sum of the moves of the previous ones, found after a first pass counting
+// the moves of all the chunks in parallel.
+static bool parallel_decode_cells(struct rle_input *in,
+                                  struct gol_board *board) {
+  size_t size = (size_t)(in->end - in->pos);
+  size_t num_chunks = min(size / PARALLEL_RLE_CHUNK + 1, 4 * gol_max_threads());
+  struct rle_chunk *chunks = calloc(num_chunks, sizeof(*chunks));
+  const char *begin = in->pos;
+  for (size_t i = 0; i < num_chunks; ++i) {
+    const char *end =
+        i + 1 == num_chunks ? in->end : in->pos + (i + 1) * size / num_chunks;
+    while (end < in->end && end > begin && isdigit((unsigned char)end[-1]))
+      end++;
+    chunks[i].in = (struct rle_input){.pos = begin, .end = end};
+    begin = end;
+  }
+  struct rle_chunks_context context = {.chunks = chunks, .board = board};
+  gol_parallel_for(num_chunks, 1, count_chunks_task, &context);
+  bool valid = true;
+  intmax_t posX = 0, posY = 0;
+  for (size_t i = 0; i < num_chunks; ++i) {
+    valid = valid && chunks[i].valid;
+    chunks[i].startX = posX;
+    chunks[i].startY = posY;
+    posX = chunks[i].endY ? chunks[i].endX : posX + chunks[i].endX;
+    posY += chunks[i].endY;
+  }
+  if (valid) {
+    gol_parallel_for(num_chunks, 1, decode_chunks_task, &context);
+    for (size_t i = 0; i < num_chunks; ++i) {
+      merge_chunk_board(chunks[i].board, board);
+      free_board(chunks[i].board);
+    }
+  }
+  free(chunks);
+  return valid;
+}
+
+static bool stream_cells(struct rle_input *in, struct gol_board *board) {
+  skip_whitespaces(in);
+  const char *pattern_end = memchr(in->pos, '!', (size_t)(in->end - in->pos));
+  if (pattern_end == NULL)
+    return false;
+  struct rle_input cells = {.pos = in->pos, .end = pattern_end};
+  if (gol_max_threads() > 1 &&
+      (uintmax_t)(pattern_end - in->pos) >= PARALLEL_RLE_CHUNK)
+    return parallel_decode_cells(&cells, board);
+  intmax_t posX = 0, posY = 0;
+  return decode_cells(&cells, &posX, &posY, board);
+}
+
+// The file is mapped in memory and read once. Returns false if it cannot be
+// mapped or does not follow the grammar, *b is then NULL.
+static bool stream_rle_file(const char *rle_file, struct gol_game **b) {
+  *b = NULL;
+  int fd = open(rle_file, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+    close(fd);
+    return false;
+  }
+  size_t size = (size_t)file_stat.st_size;
+  void *content = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (content == MAP_FAILED)
+    return false;
+  madvise(content, size, MADV_SEQUENTIAL);
+  struct rle_input in = {.pos = content, .end = (const char *)content + size};
+  *b = calloc(1, sizeof(**b));
+  (*b)->board = new_board();
+  bool parsed = stream_preheader(&in, *b) && stream_header(&in, *b) &&
+                stream_cells(&in, (*b)->board);
+  munmap(content, size);
+  if (!parsed) {
+    free_game(*b);
+    *b = NULL;
+  }
+  return parsed;
+}
+
+bool parse_rle_file(const char *rle_file, struct gol_game **b) {
+  return stream_rle_file(rle_file, b) || parse_rle_file_mpc(rle_file, b);
+}
+
+// Output of dump_rle, flushed to the file a megabyte at a time. The lines of
+// the cell grid are at most RLE_LINE_LENGTH characters long.
+#define RLE_WRITER_BUFFER (UINTMAX_C(1) << 20)
+#define RLE_LINE_LENGTH 69
+
+#define BLOCK_ONES ((block_type)~uintdef(BLOCKSIZE, 0))
+
+struct rle_writer {
+  FILE *file;
+  char *buffer;
+  size_t size;
+  size_t line_length;
+  // Rows ended since the last written one, the line jumps are written before
+  // the next alive cell
+  size_t pending_rows;
+  // First column of the current row not written yet, the row has no alive
+  // cell while it is still the first column of the bounds
+  intmax_t row_written;
+};
+
+static void flush_rle_writer(struct rle_writer *w) {
+  fwrite(w->buffer, 1, w->size, w->file);
+  w->size = 0;
+}
+
+// Writes <count><item>, the count being omitted if equal to one.
+static void write_rle_item(uintmax_t count, char item, struct rle_writer *w) {
+  char digits[24];
+  size_t num_digits = 0;
+  for (uintmax_t n = count; count > 1 && n; n /= 10)
+    digits[num_digits++] = (char)('0' + n % 10);
+  if (w->size + num_digits + 2 > RLE_WRITER_BUFFER)
+    flush_rle_writer(w);
+  if (w->line_length + num_digits + 1 > RLE_LINE_LENGTH) {
+    w->buffer[w->size++] = '\n';
+    w->line_length = 0;
+  }
+  w->line_length += num_digits + 1;
+  while (num_digits)
+    w->buffer[w->size++] = digits[--num_digits];
+  w->buffer[w->size++] = item;
+}
+
+static void write_rle_alive_run(intmax_t begin, intmax_t end, intmax_t lowerX,
+                                struct rle_writer *w) {
+  if (w->row_written == lowerX && w->pending_rows) {
+    write_rle_item(w->pending_rows, '$', w);
+    w->pending_rows = 0;
+  }
+  if (begin > w->row_written)
+    write_rle_item((uintmax_t)(begin - w->row_written), 'b', w);
+  write_rle_item((uintmax_t)(end - begin), 'o', w);
+  w->row_written = end;
+}
+
+// Non empty block of the board, the blocks are written sorted by row of blocks
+// then by column.
+struct rle_block {
+  intmax_t bx, by;
+  const struct basic_block *bb;
+};
+
+static int compare_rle_blocks(const void *b1, const void *b2) {
+  const struct rle_block *r1 = b1, *r2 = b2;
+  if (r1->by != r2->by)
+    return r1->by < r2->by ? -1 : 1;
+  return r1->bx < r2->bx ? -1 : r1->bx > r2->bx;
+}
+
+// The runs of alive cells of a row are found block by block from the bits of
+// the block rows, the runs crossing the edge of a block being joined. The
+// columns between the blocks are written as runs of dead cells.
+static void write_rle_row(const struct rle_block *row_blocks,
+                          size_t num_row_blocks, intmax_t offsetX,
+                          size_t in_bb_y, const struct gol_board_bounds *bounds,
+                          struct rle_writer *w) {
+  w->row_written = bounds->lowerX;
+  bool in_run = false;
+  intmax_t run_begin = 0, run_end = 0;
+  for (size_t k = 0; k < num_row_blocks; ++k) {
+    intmax_t originX = row_blocks[k].bx * BLOCKSIZE - offsetX;
+    block_type row = gol_block_values(row_blocks[k].bb)[in_bb_y];
+    if (bounds->lowerX > originX)
+      row &= (block_type)(BLOCK_ONES << (bounds->lowerX - originX));
+    if (bounds->upperX < originX + BLOCKSIZE - 1)
+      row &= (block_type)(BLOCK_ONES >>
+                          (originX + BLOCKSIZE - 1 - bounds->upperX));
+    while (row) {
+      size_t first = block_lowest_bit(row);
+      block_type rest = (block_type) ~(block_type)(row >> first);
+      size_t length = rest ? block_lowest_bit(rest) : BLOCKSIZE - first;
+      intmax_t begin = originX + (intmax_t)first;
+      if (in_run && begin == run_end) {
+        run_end += (intmax_t)length;
+      } else {
+        if (in_run)
+          write_rle_alive_run(run_begin, run_end, bounds->lowerX, w);
+        in_run = true;
+        run_begin = begin;
+        run_end = begin + (intmax_t)length;
+      }
+      row = (block_type)(first + length == BLOCKSIZE
+                             ? 0
+                             : row & (BLOCK_ONES << (first + length)));
     }
-    *num_written_in_line +=
-        previous_cells_in_state > 1
-            ? fprintf(output_file, "%zu%c", previous_cells_in_state, p)
-            : fprintf(output_file, "%c", p);
   }
+  if (in_run)
+    write_rle_alive_run(run_begin, run_end, bounds->lowerX, w);
+  w->pending_rows++;
 }
 
 void dump_rle(FILE *output_file, struct gol_game *b) {
@@ -466,47 +915,49 @@ void dump_rle(FILE *output_file, struct gol_game *b) {
   }
   // Header
   struct gol_board_bounds bounds = get_game_bounds(board);
+  char rule[GOL_RULE_STRING_SIZE];
+  format_gol_rule(get_game_rules(b->board), rule);
   fprintf(output_file, "x = %" PRIdMAX ", y = %" PRIdMAX ", rule = %s\n",
           bounds.upperX - bounds.lowerX + 1, bounds.upperY - bounds.lowerY + 1,
-          gol_rule_string[get_game_rules(b->board)]);
-
-  int num_written_in_line = 0;
-  size_t consecutive_empty = 0;
-  for (intmax_t j = bounds.lowerY; j <= bounds.upperY; ++j) {
-    bool previous_was_alive = false;
-    size_t previous_cells_in_state = 0;
-    for (intmax_t i = bounds.lowerX; i <= bounds.upperX; ++i) {
-      bool cell_state = read_gol_board(i, j, board);
-      if (previous_was_alive == cell_state) {
-        previous_cells_in_state++;
-      } else {
-        if (consecutive_empty) {
-          int num_to_write = consecutive_empty > 1
-                                 ? snprintf(NULL, 0, "%zu$", consecutive_empty)
-                                 : 1;
-          if (num_written_in_line + num_to_write > 69) {
-            fprintf(output_file, "\n");
-            num_written_in_line = 0;
-          }
-          num_written_in_line +=
-              consecutive_empty > 1
-                  ? fprintf(output_file, "%zu$", consecutive_empty)
-                  : fprintf(output_file, "$");
-          consecutive_empty = 0;
-        }
-        print_cell_state(output_file, previous_was_alive,
-                         previous_cells_in_state, &num_written_in_line);
-        previous_was_alive = !previous_was_alive;
-        previous_cells_in_state = 1;
-      }
-    }
-    if (previous_was_alive)
-      print_cell_state(output_file, previous_was_alive, previous_cells_in_state,
-                       &num_written_in_line);
-    consecutive_empty++;
+          rule);
+  fflush(output_file);
+
+  // Only the non empty blocks are visited, the rows of cells without blocks
+  // become line jumps.
+  size_t num_blocks = 0;
+  struct rle_block *blocks =
+      malloc(max(gol_board_num_blocks(board), 1) * sizeof(*blocks));
+  for (size_t n = 0; n < gol_board_num_blocks(board); ++n) {
+    struct rle_block block;
+    block.bb = gol_board_block(board, n, &block.bx, &block.by);
+    if (!gol_block_empty(block.bb))
+      blocks[num_blocks++] = block;
+  }
+  qsort(blocks, num_blocks, sizeof(*blocks), compare_rle_blocks);
+  struct rle_writer w = {.file = output_file,
+                         .buffer = malloc(RLE_WRITER_BUFFER)};
+  intmax_t next_row = bounds.lowerY;
+  for (size_t first = 0, last; first < num_blocks; first = last) {
+    intmax_t by = blocks[first].by;
+    for (last = first + 1; last < num_blocks && blocks[last].by == by; ++last)
+      ;
+    intmax_t originY = by * BLOCK_HEIGHT - offsetY;
+    intmax_t first_row = max(originY, bounds.lowerY);
+    intmax_t last_row = min(originY + BLOCK_HEIGHT - 1, bounds.upperY);
+    if (first_row > next_row)
+      w.pending_rows += (size_t)(first_row - next_row);
+    for (intmax_t j = first_row; j <= last_row; ++j)
+      write_rle_row(&blocks[first], last - first, offsetX,
+                    (size_t)(j - originY), &bounds, &w);
+    next_row = max(next_row, last_row + 1);
   }
-  if (num_written_in_line > 68)
-    fprintf(output_file, "\n");
-  else
-    fprintf(output_file, "!\n");
+  if (w.size + 3 > RLE_WRITER_BUFFER)
+    flush_rle_writer(&w);
+  if (w.line_length + 1 > RLE_LINE_LENGTH)
+    w.buffer[w.size++] = '\n';
+  w.buffer[w.size++] = '!';
+  w.buffer[w.size++] = '\n';
+  flush_rle_writer(&w);
+  free(w.buffer);
+  free(blocks);
 }
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2018 Maxime Schmitt <max.schmitt@unistra.fr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "scheduler.h"
+
+// Chunks [head, tail) still to be run. The owner pops from the tail, thieves
+// take the front half.
+struct task_deque {
+  alignas(64) atomic_flag lock;
+  size_t head, tail;
+};
+
+static inline void lock_deque(struct task_deque *d) {
+  while (atomic_flag_test_and_set_explicit(&d->lock, memory_order_acquire))
+    ;
+}
+
+static inline void unlock_deque(struct task_deque *d) {
+  atomic_flag_clear_explicit(&d->lock, memory_order_release);
+}
+
+static bool pop_chunk(struct task_deque *d, size_t *chunk) {
+  lock_deque(d);
+  bool found = d->head < d->tail;
+  if (found)
+    *chunk = --d->tail;
+  unlock_deque(d);
+  return found;
+}
+
+static bool steal_chunks(struct task_deque *victim, struct task_deque *thief) {
+  lock_deque(victim);
+  size_t available = victim->tail - victim->head;
+  size_t stolen = (available + 1) / 2;
+  size_t head = victim->head;
+  victim->head += stolen;
+  unlock_deque(victim);
+  if (stolen == 0)
+    return false;
+  lock_deque(thief);
+  thief->head = head;
+  thief->tail = head + stolen;
+  unlock_deque(thief);
+  return true;
+}
+
+__attribute__((const)) static inline uint64_t xorshift(uint64_t x) {
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return x;
+}
+
+size_t gol_max_threads(void) {
+#ifdef _OPENMP
+  return (size_t)omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+void gol_parallel_for(size_t num_items, size_t chunk_size,
+                      void (*task)(size_t begin, size_t end, size_t thread,
+                                   void *context),
+                      void *context) {
+  if (num_items == 0)
+    return;
+  size_t num_chunks = (num_items + chunk_size - 1) / chunk_size;
+  size_t num_threads = gol_max_threads();
+  if (num_threads > num_chunks)
+    num_threads = num_chunks;
+  if (num_threads <= 1) {
+    task(0, num_items, 0, context);
+    return;
+  }
+
+  struct task_deque *deques = aligned_alloc(
+      alignof(struct task_deque), num_threads * sizeof(*deques));
+  for (size_t t = 0; t < num_threads; ++t) {
+    atomic_flag_clear(&deques[t].lock);
+    deques[t].head = num_chunks * t / num_threads;
+    deques[t].tail = num_chunks * (t + 1) / num_threads;
+  }
+
+#pragma omp parallel num_threads((int)num_threads)
+  {
+#ifdef _OPENMP
+    size_t self = (size_t)omp_get_thread_num();
+#else
+    size_t self = 0;
+#endif
+    uint64_t seed = UINT64_C(0x9E3779B97F4A7C15) * (self + 1);
+    while (true) {
+      size_t chunk;
+      while (pop_chunk(&deques[self], &chunk)) {
+        size_t begin = chunk * chunk_size;
+        size_t end = begin + chunk_size < num_items ? begin + chunk_size
+                                                    : num_items;
+        task(begin, end, self, context);
+      }
+      // No task is ever created, so a sweep over all the deques finding
+      // nothing to steal means the work is over.
+      bool stolen = false;
+      seed = xorshift(seed);
+      for (size_t i = 0; i < num_threads && !stolen; ++i) {
+        size_t victim = (size_t)((seed + i) % num_threads);
+        if (victim != self)
+          stolen = steal_chunks(&deques[victim], &deques[self]);
+      }
+      if (!stolen)
+        break;
+    }
+  }
+  free(deques);
+}
@@ -0,0 +1,13 @@
+# Runs ${GOL} ${ARGS} -o ${OUTPUT} ${INPUT} and compares ${OUTPUT} to
+# ${EXPECTED}.
+separate_arguments(ARGS)
+execute_process(COMMAND ${GOL} ${ARGS} -o ${OUTPUT} ${INPUT}
+                RESULT_VARIABLE result OUTPUT_QUIET)
+if(result)
+  message(FATAL_ERROR "${GOL} failed on ${INPUT}: ${result}")
+endif()
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${OUTPUT} ${EXPECTED}
+                RESULT_VARIABLE differ)
+if(differ)
+  message(FATAL_ERROR "${OUTPUT} differs from ${EXPECTED}")
+endif()